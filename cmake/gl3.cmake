@@ -1,17 +1,17 @@
-FIND_PACKAGE(GLEW REQUIRED)
-INCLUDE_DIRECTORIES(${GLEW_INCLUDE_DIRS})
-LINK_LIBRARIES(${GLEW_LIBRARIES})
+IF (NOT PLANETS_HEADLESS)
+	FIND_PACKAGE(GLEW REQUIRED)
+	INCLUDE_DIRECTORIES(${GLEW_INCLUDE_DIRS})
+	IF (WIN32)
+		find_package(glfw3 CONFIG REQUIRED)
+		LIST(APPEND stdgl_libraries glfw ${GLEW_LIBRARIES})
+	ELSE ()
+		FIND_PACKAGE(PkgConfig REQUIRED)
+		pkg_search_module(GLFW3 REQUIRED glfw3)
+		INCLUDE_DIRECTORIES(${GLFW3_INCLUDE_DIRS})
+		LIST(APPEND stdgl_libraries ${GLFW3_STATIC_LIBRARIES} ${GLEW_LIBRARIES})
+	ENDIF ()
 
-IF (WIN32)
-	find_package(glfw3 CONFIG REQUIRED)
-	LIST(APPEND stdgl_libraries glfw ${GLEW_LIBRARIES})
-ELSE ()
-	FIND_PACKAGE(PkgConfig REQUIRED)
-	pkg_search_module(GLFW3 REQUIRED glfw3)
-	INCLUDE_DIRECTORIES(${GLFW3_INCLUDE_DIRS})
-	LIST(APPEND stdgl_libraries ${GLFW3_STATIC_LIBRARIES} ${GLEW_LIBRARIES})
-ENDIF ()
 
-
-message(STATUS "GLEW_LIBRARIES=${GLEW_LIBRARIES}")
-message(STATUS "GLFW_LIBRARIES=${GLFW3_STATIC_LIBRARIES}")
+	message(STATUS "GLEW_LIBRARIES=${GLEW_LIBRARIES}")
+	message(STATUS "GLFW_LIBRARIES=${GLFW3_STATIC_LIBRARIES}")
+ENDIF (NOT PLANETS_HEADLESS)
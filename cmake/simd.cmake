@@ -0,0 +1,9 @@
+# SSE2 is always there on x86-64, AVX2 has to be asked for
+IF (PLANETS_AVX2)
+	IF (MSVC)
+		SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} /arch:AVX2")
+	ELSE ()
+		SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -mavx2")
+	ENDIF ()
+	MESSAGE(STATUS "Building with AVX2")
+ENDIF (PLANETS_AVX2)
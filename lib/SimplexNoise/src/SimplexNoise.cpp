@@ -27,7 +27,16 @@
 #include "SimplexNoise.h"
 
 #include <cstdint>  // int32_t/uint8_t
-#include <stdlib.h>
+#include <cmath>    // fabs
+#include <cstring>  // memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMPLEXNOISE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMPLEXNOISE_SSE2
+#endif
 
 /**
  * Computes the largest integer value not greater than the float one
@@ -55,9 +64,8 @@ static inline int32_t fastfloor(float fp) {
  * that it is not a problem for graphic texture as the noise features disappear
  * at a distance far enough to be able to see a repeatable pattern of 256.
  *
- * This needs to be exactly the same for all instances on all platforms,
- * so it's easiest to just keep it as static explicit data.
- * This also removes the need for any initialisation of this class.
+ * Each instance starts from a copy of this table and shuffles it with its seed,
+ * so the same seed gives the same table on all platforms.
  *
  * Note that making this an uint32_t[] instead of a uint8_t[] might make the
  * code run faster on platforms with a high penalty for unaligned single
@@ -69,7 +77,7 @@ static inline int32_t fastfloor(float fp) {
  * A vector-valued noise over 3D accesses it 96 times, and a
  * float-valued 4D noise 64 times. We want this to fit in the cache!
  */
-uint8_t perm[256] = {
+static const uint8_t kReferencePerm[256] = {
     151, 160, 137, 91, 90, 15,
     131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
     190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
@@ -97,8 +105,8 @@ uint8_t perm[256] = {
  *
  * @return 8-bits hashed value
  */
-static inline uint8_t hash(int32_t i) {
-    return perm[static_cast<uint8_t>(i)];
+inline uint8_t SimplexNoise::hash(int32_t i) const {
+    return mPerm[static_cast<uint8_t>(i)];
 }
 
 /* NOTE Gradient table to test if lookup-table are more efficient than calculs
@@ -164,18 +172,35 @@ static float grad(int32_t hash, float x, float y, float z) {
     return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
 }
 
+/**
+ * SplitMix64 step: a small seeded generator that keeps its whole state in the caller,
+ * unlike rand(), so shuffling never touches global state.
+ *
+ * @param[in,out] state generator state, advanced by each call
+ *
+ * @return 64 pseudo-random bits
+ */
+static inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Fisher-Yates shuffle of the reference permutation table, driven by the seed
+ *
+ * @param[in] seed  seed of the permutation
+ */
 void SimplexNoise::shuffle(unsigned int seed)
 {
-    srand(seed);
-    for (int i = 0; i < 1000; i++) {
-        // generate random indices
-        int idx1 = rand() & 255;
-        int idx2 = rand() & 255;
-        
-        // Swap the two indices
-        uint8_t temp = perm[idx1];
-        perm[idx1] = perm[idx2];
-        perm[idx2] = temp;
+    std::memcpy(mPerm, kReferencePerm, sizeof(mPerm));
+    uint64_t state = seed;
+    for (int i = 255; i > 0; i--) {
+        int j = static_cast<int>(splitmix64(state) % static_cast<uint64_t>(i + 1));
+        uint8_t temp = mPerm[i];
+        mPerm[i] = mPerm[j];
+        mPerm[j] = temp;
     }
 }
 
@@ -188,7 +213,7 @@ void SimplexNoise::shuffle(unsigned int seed)
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x) {
+float SimplexNoise::noise(float x) const {
     float n0, n1;   // Noise contributions from the two "corners"
 
     // No need to skew the input space in 1D
@@ -227,7 +252,7 @@ float SimplexNoise::noise(float x) {
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x, float y) {
+float SimplexNoise::noise(float x, float y) const {
     float n0, n1, n2;   // Noise contributions from the three corners
 
     // Skewing/Unskewing factors for 2D
@@ -315,7 +340,7 @@ float SimplexNoise::noise(float x, float y) {
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x, float y, float z) {
+float SimplexNoise::noise(float x, float y, float z) const {
     float n0, n1, n2, n3; // Noise contributions from the four corners
 
     // Skewing/Unskewing factors for 3D
@@ -412,6 +437,43 @@ float SimplexNoise::noise(float x, float y, float z) {
 }
 
 
+/**
+ * Number of leading octaves worth evaluating for a fBm summation
+ *
+ *  Each octave of noise is within [-amplitude; amplitude], so skipping the octaves from k onwards
+ * changes the normalized result by at most the sum of their amplitudes over the sum of all of them.
+ * With the usual persistence < 1 that tail shrinks geometrically, and by the time it is below
+ * float precision the frequency has grown so much that the noise input has no precision left either.
+ * The skipped octaves still count towards the normalization, so the result only loses their noise.
+ *
+ * @param[in] octaves   number of fraction of noise requested
+ *
+ * @return number of octaves evaluated, between 1 and octaves (octaves when the tolerance is 0)
+ */
+size_t SimplexNoise::effectiveOctaves(size_t octaves) const {
+    if (mTolerance <= 0.0f) {
+        return octaves;
+    }
+
+    double total = 0.0;
+    double amplitude = mAmplitude;
+    for (size_t i = 0; i < octaves; i++) {
+        total += std::fabs(amplitude);
+        amplitude *= mPersistence;
+    }
+
+    double remaining = total;
+    amplitude = mAmplitude;
+    for (size_t i = 1; i < octaves; i++) {
+        remaining -= std::fabs(amplitude);
+        amplitude *= mPersistence;
+        if (remaining <= mTolerance * total) {
+            return i;
+        }
+    }
+    return octaves;
+}
+
 /**
  * Fractal/Fractional Brownian Motion (fBm) summation of 1D Perlin Simplex noise
  *
@@ -426,8 +488,11 @@ float SimplexNoise::fractal(size_t octaves, float x) const {
     float frequency = mFrequency;
     float amplitude = mAmplitude;
 
+    const size_t evaluated = effectiveOctaves(octaves);
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency));
+        if (i < evaluated) {
+            output += (amplitude * noise(x * frequency));
+        }
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -452,8 +517,11 @@ float SimplexNoise::fractal(size_t octaves, float x, float y) const {
     float frequency = mFrequency;
     float amplitude = mAmplitude;
 
+    const size_t evaluated = effectiveOctaves(octaves);
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency, y * frequency));
+        if (i < evaluated) {
+            output += (amplitude * noise(x * frequency, y * frequency));
+        }
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -479,8 +547,11 @@ float SimplexNoise::fractal(size_t octaves, float x, float y, float z) const {
     float frequency = mFrequency;
     float amplitude = mAmplitude;
 
+    const size_t evaluated = effectiveOctaves(octaves);
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency, y * frequency, z * frequency));
+        if (i < evaluated) {
+            output += (amplitude * noise(x * frequency, y * frequency, z * frequency));
+        }
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -489,3 +560,216 @@ float SimplexNoise::fractal(size_t octaves, float x, float y, float z) const {
 
     return (output / denom);
 }
+
+#if defined(SIMPLEXNOISE_AVX2) || defined(SIMPLEXNOISE_SSE2)
+
+namespace {
+
+#if defined(SIMPLEXNOISE_AVX2)
+
+const size_t kLanes = 8;
+typedef __m256 Lane;
+typedef __m256i IntLane;
+
+inline Lane load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+inline Lane set1(float f) { return _mm256_set1_ps(f); }
+inline Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+inline Lane divide(Lane a, Lane b) { return _mm256_div_ps(a, b); }
+inline Lane lessThan(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Lane greaterEqual(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline Lane bitAnd(Lane a, Lane b) { return _mm256_and_ps(a, b); }
+inline Lane bitAndNot(Lane a, Lane b) { return _mm256_andnot_ps(a, b); }
+inline Lane bitOr(Lane a, Lane b) { return _mm256_or_ps(a, b); }
+inline Lane bitXor(Lane a, Lane b) { return _mm256_xor_ps(a, b); }
+
+inline IntLane loadInt(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline void storeInt(int32_t* p, IntLane v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline IntLane set1Int(int32_t i) { return _mm256_set1_epi32(i); }
+inline IntLane addInt(IntLane a, IntLane b) { return _mm256_add_epi32(a, b); }
+inline IntLane andInt(IntLane a, IntLane b) { return _mm256_and_si256(a, b); }
+inline IntLane orInt(IntLane a, IntLane b) { return _mm256_or_si256(a, b); }
+inline IntLane equalInt(IntLane a, IntLane b) { return _mm256_cmpeq_epi32(a, b); }
+inline IntLane greaterThanInt(IntLane a, IntLane b) { return _mm256_cmpgt_epi32(a, b); }
+template <int bits> inline IntLane shiftLeftInt(IntLane a) { return _mm256_slli_epi32(a, bits); }
+inline IntLane truncate(Lane a) { return _mm256_cvttps_epi32(a); }
+inline Lane toFloat(IntLane a) { return _mm256_cvtepi32_ps(a); }
+inline IntLane asInt(Lane a) { return _mm256_castps_si256(a); }
+inline Lane asFloat(IntLane a) { return _mm256_castsi256_ps(a); }
+
+#else
+
+const size_t kLanes = 4;
+typedef __m128 Lane;
+typedef __m128i IntLane;
+
+inline Lane load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm_storeu_ps(p, v); }
+inline Lane set1(float f) { return _mm_set1_ps(f); }
+inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+inline Lane divide(Lane a, Lane b) { return _mm_div_ps(a, b); }
+inline Lane lessThan(Lane a, Lane b) { return _mm_cmplt_ps(a, b); }
+inline Lane greaterEqual(Lane a, Lane b) { return _mm_cmpge_ps(a, b); }
+inline Lane bitAnd(Lane a, Lane b) { return _mm_and_ps(a, b); }
+inline Lane bitAndNot(Lane a, Lane b) { return _mm_andnot_ps(a, b); }
+inline Lane bitOr(Lane a, Lane b) { return _mm_or_ps(a, b); }
+inline Lane bitXor(Lane a, Lane b) { return _mm_xor_ps(a, b); }
+
+inline IntLane loadInt(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void storeInt(int32_t* p, IntLane v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline IntLane set1Int(int32_t i) { return _mm_set1_epi32(i); }
+inline IntLane addInt(IntLane a, IntLane b) { return _mm_add_epi32(a, b); }
+inline IntLane andInt(IntLane a, IntLane b) { return _mm_and_si128(a, b); }
+inline IntLane orInt(IntLane a, IntLane b) { return _mm_or_si128(a, b); }
+inline IntLane equalInt(IntLane a, IntLane b) { return _mm_cmpeq_epi32(a, b); }
+inline IntLane greaterThanInt(IntLane a, IntLane b) { return _mm_cmpgt_epi32(a, b); }
+template <int bits> inline IntLane shiftLeftInt(IntLane a) { return _mm_slli_epi32(a, bits); }
+inline IntLane truncate(Lane a) { return _mm_cvttps_epi32(a); }
+inline Lane toFloat(IntLane a) { return _mm_cvtepi32_ps(a); }
+inline IntLane asInt(Lane a) { return _mm_castps_si128(a); }
+inline Lane asFloat(IntLane a) { return _mm_castsi128_ps(a); }
+
+#endif
+
+// mask ? a : b
+inline Lane select(Lane mask, Lane a, Lane b) { return bitOr(bitAnd(mask, a), bitAndNot(mask, b)); }
+
+// fastfloor(): truncate, then step down where that rounded up. Adding the
+// all-ones compare mask subtracts one.
+inline IntLane floorLanes(Lane fp) {
+    IntLane i = truncate(fp);
+    return addInt(i, asInt(lessThan(fp, toFloat(i))));
+}
+
+// grad() of kLanes corners, picking u and v with masks instead of branches
+inline Lane gradLanes(IntLane h, Lane x, Lane y, Lane z) {
+    Lane u = select(asFloat(greaterThanInt(h, set1Int(7))), y, x);
+    Lane v_is_y = asFloat(greaterThanInt(set1Int(4), h));
+    Lane v_is_x = asFloat(orInt(equalInt(h, set1Int(12)), equalInt(h, set1Int(14))));
+    Lane v = select(v_is_y, y, select(v_is_x, x, z));
+    Lane u_sign = asFloat(shiftLeftInt<31>(andInt(h, set1Int(1))));
+    Lane v_sign = asFloat(shiftLeftInt<30>(andInt(h, set1Int(2))));
+    return add(bitXor(u, u_sign), bitXor(v, v_sign));
+}
+
+// Contribution of one simplex corner, zero outside its radius
+inline Lane cornerLanes(IntLane h, Lane x, Lane y, Lane z) {
+    Lane t = sub(sub(sub(set1(0.6f), mul(x, x)), mul(y, y)), mul(z, z));
+    Lane t2 = mul(t, t);
+    Lane n = mul(mul(t2, t2), gradLanes(h, x, y, z));
+    return bitAndNot(lessThan(t, set1(0.0f)), n);
+}
+
+/**
+ * 3D Perlin simplex noise of kLanes points, following SimplexNoise::noise(x, y, z)
+ * operation for operation so the results are identical. Only the permutation
+ * table lookups are done one lane at a time.
+ */
+Lane noiseLanes(const uint8_t* perm, Lane x, Lane y, Lane z) {
+    const float F3 = 1.0f / 3.0f;
+    const float G3 = 1.0f / 6.0f;
+    const Lane one = set1(1.0f);
+    const Lane all = asFloat(set1Int(-1));
+
+    Lane s = mul(add(add(x, y), z), set1(F3));
+    IntLane i = floorLanes(add(x, s));
+    IntLane j = floorLanes(add(y, s));
+    IntLane k = floorLanes(add(z, s));
+    Lane t = mul(toFloat(addInt(addInt(i, j), k)), set1(G3));
+    Lane x0 = sub(x, sub(toFloat(i), t));
+    Lane y0 = sub(y, sub(toFloat(j), t));
+    Lane z0 = sub(z, sub(toFloat(k), t));
+
+    // The same rank ordering as the branches of the scalar version
+    Lane x_ge_y = greaterEqual(x0, y0);
+    Lane y_ge_z = greaterEqual(y0, z0);
+    Lane x_ge_z = greaterEqual(x0, z0);
+    Lane i1 = bitAnd(x_ge_y, bitOr(y_ge_z, x_ge_z));
+    Lane j1 = bitAndNot(x_ge_y, y_ge_z);
+    Lane k1 = bitAndNot(bitOr(y_ge_z, bitAnd(x_ge_y, x_ge_z)), all);
+    Lane i2 = bitOr(x_ge_y, bitAnd(y_ge_z, x_ge_z));
+    Lane j2 = bitOr(bitAndNot(x_ge_y, all), y_ge_z);
+    Lane k2 = bitAndNot(bitAnd(y_ge_z, bitOr(x_ge_y, x_ge_z)), all);
+
+    Lane x1 = add(sub(x0, bitAnd(i1, one)), set1(G3));
+    Lane y1 = add(sub(y0, bitAnd(j1, one)), set1(G3));
+    Lane z1 = add(sub(z0, bitAnd(k1, one)), set1(G3));
+    Lane x2 = add(sub(x0, bitAnd(i2, one)), set1(2.0f * G3));
+    Lane y2 = add(sub(y0, bitAnd(j2, one)), set1(2.0f * G3));
+    Lane z2 = add(sub(z0, bitAnd(k2, one)), set1(2.0f * G3));
+    Lane x3 = add(sub(x0, one), set1(3.0f * G3));
+    Lane y3 = add(sub(y0, one), set1(3.0f * G3));
+    Lane z3 = add(sub(z0, one), set1(3.0f * G3));
+
+    // Hash the four corners of every lane
+    alignas(32) int32_t cell[3][kLanes];
+    alignas(32) int32_t offset[6][kLanes];
+    alignas(32) int32_t hashes[4][kLanes];
+    storeInt(cell[0], i);
+    storeInt(cell[1], j);
+    storeInt(cell[2], k);
+    const IntLane one_int = set1Int(1);
+    storeInt(offset[0], andInt(asInt(i1), one_int));
+    storeInt(offset[1], andInt(asInt(j1), one_int));
+    storeInt(offset[2], andInt(asInt(k1), one_int));
+    storeInt(offset[3], andInt(asInt(i2), one_int));
+    storeInt(offset[4], andInt(asInt(j2), one_int));
+    storeInt(offset[5], andInt(asInt(k2), one_int));
+    for (size_t l = 0; l < kLanes; l++) {
+        int32_t ci = cell[0][l], cj = cell[1][l], ck = cell[2][l];
+        hashes[0][l] = perm[static_cast<uint8_t>(ci + perm[static_cast<uint8_t>(cj + perm[static_cast<uint8_t>(ck)])])] & 15;
+        hashes[1][l] = perm[static_cast<uint8_t>(ci + offset[0][l] + perm[static_cast<uint8_t>(cj + offset[1][l] + perm[static_cast<uint8_t>(ck + offset[2][l])])])] & 15;
+        hashes[2][l] = perm[static_cast<uint8_t>(ci + offset[3][l] + perm[static_cast<uint8_t>(cj + offset[4][l] + perm[static_cast<uint8_t>(ck + offset[5][l])])])] & 15;
+        hashes[3][l] = perm[static_cast<uint8_t>(ci + 1 + perm[static_cast<uint8_t>(cj + 1 + perm[static_cast<uint8_t>(ck + 1)])])] & 15;
+    }
+
+    Lane n0 = cornerLanes(loadInt(hashes[0]), x0, y0, z0);
+    Lane n1 = cornerLanes(loadInt(hashes[1]), x1, y1, z1);
+    Lane n2 = cornerLanes(loadInt(hashes[2]), x2, y2, z2);
+    Lane n3 = cornerLanes(loadInt(hashes[3]), x3, y3, z3);
+    return mul(set1(32.0f), add(add(add(n0, n1), n2), n3));
+}
+
+}  // namespace
+
+void SimplexNoise::fractal(size_t octaves, const float* xs, const float* ys, const float* zs, float* out, size_t n) const {
+    const size_t evaluated = effectiveOctaves(octaves);
+    size_t simd_count = n - n % kLanes;
+    for (size_t p = 0; p < simd_count; p += kLanes) {
+        Lane x = load(xs + p);
+        Lane y = load(ys + p);
+        Lane z = load(zs + p);
+
+        Lane output = set1(0.f);
+        float denom = 0.f;
+        float frequency = mFrequency;
+        float amplitude = mAmplitude;
+        for (size_t i = 0; i < octaves; i++) {
+            if (i < evaluated) {
+                Lane f = set1(frequency);
+                output = add(output, mul(set1(amplitude), noiseLanes(mPerm, mul(x, f), mul(y, f), mul(z, f))));
+            }
+            denom += amplitude;
+
+            frequency *= mLacunarity;
+            amplitude *= mPersistence;
+        }
+        store(out + p, divide(output, set1(denom)));
+    }
+
+    for (size_t p = simd_count; p < n; p++)
+        out[p] = fractal(octaves, xs[p], ys[p], zs[p]);
+}
+
+#else
+
+void SimplexNoise::fractal(size_t octaves, const float* xs, const float* ys, const float* zs, float* out, size_t n) const {
+    for (size_t p = 0; p < n; p++)
+        out[p] = fractal(octaves, xs[p], ys[p], zs[p]);
+}
+
+#endif
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <cstddef>  // size_t
+#include <cstdint>  // uint8_t
 
 /**
  * @brief A Perlin Simplex Noise C++ Implementation (1D, 2D, 3D, 4D).
@@ -17,17 +18,25 @@
 class SimplexNoise {
 public:
     // 1D Perlin simplex noise
-    static float noise(float x);
+    float noise(float x) const;
     // 2D Perlin simplex noise
-    static float noise(float x, float y);
+    float noise(float x, float y) const;
     // 3D Perlin simplex noise
-    static float noise(float x, float y, float z);
+    float noise(float x, float y, float z) const;
 
     // Fractal/Fractional Brownian Motion (fBm) noise summation
     float fractal(size_t octaves, float x) const;
     float fractal(size_t octaves, float x, float y) const;
     float fractal(size_t octaves, float x, float y, float z) const;
 
+    // 3D fBm of n points at once, 8 (AVX2) or 4 (SSE2) points per instruction.
+    // Gives the same results as calling fractal() on each point.
+    void fractal(size_t octaves, const float* xs, const float* ys, const float* zs, float* out, size_t n) const;
+
+    // Number of the given octaves fractal() actually evaluates: the trailing
+    // octaves that together could move the result by at most the tolerance are skipped
+    size_t effectiveOctaves(size_t octaves) const;
+
     /**
      * Constructor of to initialize a fractal noise summation
      *
@@ -35,25 +44,35 @@ public:
      * @param[in] amplitude    Amplitude ("height") of the first octave of noise (default to 1.0)
      * @param[in] lacunarity   Lacunarity specifies the frequency multiplier between successive octaves (default to 2.0).
      * @param[in] persistence  Persistence is the loss of amplitude between successive octaves (usually 1/lacunarity)
+     * @param[in] seed         Seed of this instance's permutation table. Instances never share state,
+     *                         so they can be built and used from any number of threads.
+     * @param[in] tolerance    Largest change of the fractal() result allowed from skipping the
+     *                         smallest octaves (default to 0.0, every octave is evaluated)
      */
     explicit SimplexNoise(float frequency = 1.0f,
                           float amplitude = 1.0f,
                           float lacunarity = 2.0f,
                           float persistence = 0.5f,
-                          unsigned int seed = 0) :
+                          unsigned int seed = 0,
+                          float tolerance = 0.0f) :
         mFrequency(frequency),
         mAmplitude(amplitude),
         mLacunarity(lacunarity),
-        mPersistence(persistence) {
+        mPersistence(persistence),
+        mTolerance(tolerance) {
             shuffle(seed);
     }
 
 private:
     void shuffle(unsigned int seed);
+    uint8_t hash(int32_t i) const;
+
+    uint8_t mPerm[256]; ///< Permutation table, shuffled from the reference one by the seed
 
     // Parameters of Fractional Brownian Motion (fBm) : sum of N "octaves" of noise
     float mFrequency;   ///< Frequency ("width") of the first octave of noise (default to 1.0)
     float mAmplitude;   ///< Amplitude ("height") of the first octave of noise (default to 1.0)
     float mLacunarity;  ///< Lacunarity specifies the frequency multiplier between successive octaves (default to 2.0).
     float mPersistence; ///< Persistence is the loss of amplitude between successive octaves (usually 1/lacunarity)
+    float mTolerance;   ///< Largest change of the fBm result allowed from skipping octaves (default to 0.0)
 };
@@ -10,8 +10,9 @@
 #include "SimplexNoise.h"
 
 int main() {
+    SimplexNoise simplex;                   // Default parameters and seed
     float x     = 0.123f;                   // Define a float coordinate
-    float noise = SimplexNoise::noise(x);   // Get the noise value for the coordinate
+    float noise = simplex.noise(x);         // Get the noise value for the coordinate
     (void)noise;
 
     return 0;
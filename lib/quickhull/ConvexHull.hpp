@@ -75,7 +75,8 @@ namespace quickhull {
 		}
 		
 		// Construct vertex and index buffers from half edge mesh and pointcloud
-		ConvexHull(const MeshBuilder<T>& mesh, const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices) {
+		template<typename IndexType>
+		ConvexHull(const MeshBuilder<T, IndexType>& mesh, const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices) {
 			if (!useOriginalIndices) {
 				m_optimizedVertexBuffer.reset(new std::vector<Vector3<T>>());
 			}
@@ -1,4 +1,5 @@
 #include "Structs/Mesh.hpp"
+#include <limits>
 
 #ifndef HalfEdgeMesh_h
 #define HalfEdgeMesh_h
@@ -21,27 +22,50 @@ namespace quickhull {
 		};
 		
 		std::vector<Vector3<FloatType>> m_vertices;
+		std::vector<IndexType> m_vertexIndices; // Index of each vertex in the original point cloud
 		std::vector<Face> m_faces;
 		std::vector<HalfEdge> m_halfEdges;
 		
-		HalfEdgeMesh(const MeshBuilder<FloatType>& builderObject, const VertexDataSource<FloatType>& vertexData )
+		HalfEdgeMesh() = default;
+
+		template<typename BuilderIndexType>
+		HalfEdgeMesh(const MeshBuilder<FloatType, BuilderIndexType>& builderObject, const VertexDataSource<FloatType>& vertexData )
+		{
+			build(builderObject, vertexData);
+		}
+		
+		// Replaces the contents with the mesh in the builder. The vectors keep their capacity, so rebuilding a mesh of similar size doesn't allocate.
+		template<typename BuilderIndexType>
+		void build(const MeshBuilder<FloatType, BuilderIndexType>& builderObject, const VertexDataSource<FloatType>& vertexData)
 		{
-			std::unordered_map<IndexType,IndexType> faceMapping;
-			std::unordered_map<IndexType,IndexType> halfEdgeMapping;
-			std::unordered_map<IndexType, IndexType> vertexMapping;
+			m_vertices.clear();
+			m_vertexIndices.clear();
+			m_faces.clear();
+			m_halfEdges.clear();
+			
+			// The builder's faces, half edges and vertices are numbered densely, so plain vectors do for the mappings
+			const IndexType unmapped = std::numeric_limits<IndexType>::max();
+			m_faceMapping.assign(builderObject.m_faces.size(), unmapped);
+			m_halfEdgeMapping.assign(builderObject.m_halfEdges.size(), unmapped);
+			m_vertexMapping.assign(vertexData.size(), unmapped);
+			
+			const size_t faceCount = builderObject.m_faces.size() - builderObject.m_disabledFaces.size();
+			m_faces.reserve(faceCount);
+			m_halfEdges.reserve(faceCount * 3);
 			
 			size_t i=0;
 			for (const auto& face : builderObject.m_faces) {
 				if (!face.isDisabled()) {
 					m_faces.push_back({static_cast<IndexType>(face.m_he)});
-					faceMapping[i] = m_faces.size()-1;
+					m_faceMapping[i] = m_faces.size()-1;
 					
 					const auto heIndices = builderObject.getHalfEdgeIndicesOfFace(face);
 					for (const auto heIndex : heIndices) {
 						const IndexType vertexIndex = builderObject.m_halfEdges[heIndex].m_endVertex;
-						if (vertexMapping.count(vertexIndex)==0) {
+						if (m_vertexMapping[vertexIndex] == unmapped) {
 							m_vertices.push_back(vertexData[vertexIndex]);
-							vertexMapping[vertexIndex] = m_vertices.size()-1;
+							m_vertexIndices.push_back(vertexIndex);
+							m_vertexMapping[vertexIndex] = m_vertices.size()-1;
 						}
 					}
 				}
@@ -52,24 +76,29 @@ namespace quickhull {
 			for (const auto& halfEdge : builderObject.m_halfEdges) {
 				if (!halfEdge.isDisabled()) {
 					m_halfEdges.push_back({static_cast<IndexType>(halfEdge.m_endVertex),static_cast<IndexType>(halfEdge.m_opp),static_cast<IndexType>(halfEdge.m_face),static_cast<IndexType>(halfEdge.m_next)});
-					halfEdgeMapping[i] = m_halfEdges.size()-1;
+					m_halfEdgeMapping[i] = m_halfEdges.size()-1;
 				}
 				i++;
 			}
 			
 			for (auto& face : m_faces) {
-				assert(halfEdgeMapping.count(face.m_halfEdgeIndex) == 1);
-				face.m_halfEdgeIndex = halfEdgeMapping[face.m_halfEdgeIndex];
+				assert(m_halfEdgeMapping[face.m_halfEdgeIndex] != unmapped);
+				face.m_halfEdgeIndex = m_halfEdgeMapping[face.m_halfEdgeIndex];
 			}
 			
 			for (auto& he : m_halfEdges) {
-				he.m_face = faceMapping[he.m_face];
-				he.m_opp = halfEdgeMapping[he.m_opp];
-				he.m_next = halfEdgeMapping[he.m_next];
-				he.m_endVertex = vertexMapping[he.m_endVertex];
+				he.m_face = m_faceMapping[he.m_face];
+				he.m_opp = m_halfEdgeMapping[he.m_opp];
+				he.m_next = m_halfEdgeMapping[he.m_next];
+				he.m_endVertex = m_vertexMapping[he.m_endVertex];
 			}
 		}
 		
+	private:
+		// Scratch space of build(), kept for its capacity
+		std::vector<IndexType> m_faceMapping;
+		std::vector<IndexType> m_halfEdgeMapping;
+		std::vector<IndexType> m_vertexMapping;
 	};
 }
 
@@ -0,0 +1,111 @@
+#ifndef QuickHull_PlaneDistances_hpp
+#define QuickHull_PlaneDistances_hpp
+
+#include "Structs/Plane.hpp"
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define QUICKHULL_PLANE_DISTANCES_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUICKHULL_PLANE_DISTANCES_SSE2
+#endif
+
+namespace quickhull {
+
+	namespace mathutils {
+
+		// Plain loop version of PlaneDistances::compute, also used for the points left over after the SIMD batches
+		template <typename T>
+		inline void getSignedDistancesToPlaneScalar(const Plane<T>& p, const T* xs, const T* ys, const T* zs, size_t count, T* out) {
+			for (size_t i=0;i<count;i++) {
+				out[i] = p.m_N.x*xs[i] + p.m_N.y*ys[i] + p.m_N.z*zs[i] + p.m_D;
+			}
+		}
+
+		// Batched getSignedDistanceToPlane for points stored as separate x, y and z arrays: out[i] is the signed distance of point
+		// (xs[i],ys[i],zs[i]). Specialized for float and double with SIMD where available (8 floats or 4 doubles at a time with AVX,
+		// 4 or 2 with SSE2). Every version multiplies and adds in the same order as getSignedDistanceToPlane, so the distances are
+		// bit-identical to it.
+		template <typename T>
+		struct PlaneDistances {
+			static void compute(const Plane<T>& p, const T* xs, const T* ys, const T* zs, size_t count, T* out) {
+				getSignedDistancesToPlaneScalar(p, xs, ys, zs, count, out);
+			}
+		};
+
+#if defined(QUICKHULL_PLANE_DISTANCES_AVX) || defined(QUICKHULL_PLANE_DISTANCES_SSE2)
+
+#if defined(QUICKHULL_PLANE_DISTANCES_AVX)
+		struct FloatLanes {
+			typedef __m256 Lane;
+			static const size_t kCount = 8;
+			static Lane load(const float* p) { return _mm256_loadu_ps(p); }
+			static void store(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+			static Lane set1(float f) { return _mm256_set1_ps(f); }
+			static Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+			static Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+		};
+
+		struct DoubleLanes {
+			typedef __m256d Lane;
+			static const size_t kCount = 4;
+			static Lane load(const double* p) { return _mm256_loadu_pd(p); }
+			static void store(double* p, Lane v) { _mm256_storeu_pd(p, v); }
+			static Lane set1(double f) { return _mm256_set1_pd(f); }
+			static Lane add(Lane a, Lane b) { return _mm256_add_pd(a, b); }
+			static Lane mul(Lane a, Lane b) { return _mm256_mul_pd(a, b); }
+		};
+#else
+		struct FloatLanes {
+			typedef __m128 Lane;
+			static const size_t kCount = 4;
+			static Lane load(const float* p) { return _mm_loadu_ps(p); }
+			static void store(float* p, Lane v) { _mm_storeu_ps(p, v); }
+			static Lane set1(float f) { return _mm_set1_ps(f); }
+			static Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+			static Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+		};
+
+		struct DoubleLanes {
+			typedef __m128d Lane;
+			static const size_t kCount = 2;
+			static Lane load(const double* p) { return _mm_loadu_pd(p); }
+			static void store(double* p, Lane v) { _mm_storeu_pd(p, v); }
+			static Lane set1(double f) { return _mm_set1_pd(f); }
+			static Lane add(Lane a, Lane b) { return _mm_add_pd(a, b); }
+			static Lane mul(Lane a, Lane b) { return _mm_mul_pd(a, b); }
+		};
+#endif
+
+		template <typename T, typename Lanes>
+		struct SIMDPlaneDistances {
+			static void compute(const Plane<T>& p, const T* xs, const T* ys, const T* zs, size_t count, T* out) {
+				const typename Lanes::Lane nx = Lanes::set1(p.m_N.x);
+				const typename Lanes::Lane ny = Lanes::set1(p.m_N.y);
+				const typename Lanes::Lane nz = Lanes::set1(p.m_N.z);
+				const typename Lanes::Lane d = Lanes::set1(p.m_D);
+				const size_t simdCount = count - count % Lanes::kCount;
+				for (size_t i=0;i<simdCount;i+=Lanes::kCount) {
+					typename Lanes::Lane D = Lanes::add(Lanes::mul(nx, Lanes::load(xs+i)), Lanes::mul(ny, Lanes::load(ys+i)));
+					D = Lanes::add(Lanes::add(D, Lanes::mul(nz, Lanes::load(zs+i))), d);
+					Lanes::store(out+i, D);
+				}
+				getSignedDistancesToPlaneScalar(p, xs+simdCount, ys+simdCount, zs+simdCount, count-simdCount, out+simdCount);
+			}
+		};
+
+		template <>
+		struct PlaneDistances<float> : SIMDPlaneDistances<float, FloatLanes> {};
+
+		template <>
+		struct PlaneDistances<double> : SIMDPlaneDistances<double, DoubleLanes> {};
+
+#endif
+
+	}
+
+}
+
+#endif
@@ -1,14 +1,26 @@
 #include "QuickHull.hpp"
 #include "MathUtils.hpp"
+#include "PlaneDistances.hpp"
 #include <cmath>
 #include <cassert>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include "Structs/Mesh.hpp"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace quickhull {
 
+	template<typename T, typename IndexType>
+	const size_t QuickHull<T, IndexType>::kMinParallelPoints;
+
+	template<typename T, typename IndexType>
+	const size_t QuickHull<T, IndexType>::kAssignBlockSize;
+
 	template<>
 	float defaultEps() { 
 		return 0.0001f;
@@ -23,35 +35,42 @@ namespace quickhull {
 	 * Implementation of the algorithm
 	 */
 	
-	template<typename T>
-	ConvexHull<T> QuickHull<T>::getConvexHull(const std::vector<Vector3<T>>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
+	template<typename T, typename IndexType>
+	ConvexHull<T> QuickHull<T, IndexType>::getConvexHull(const std::vector<Vector3<T>>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
 		VertexDataSource<T> vertexDataSource(pointCloud);
 		return getConvexHull(vertexDataSource,CCW,useOriginalIndices,epsilon);
 	}
 	
-	template<typename T>
-	ConvexHull<T> QuickHull<T>::getConvexHull(const Vector3<T>* vertexData, size_t vertexCount, bool CCW, bool useOriginalIndices, T epsilon) {
+	template<typename T, typename IndexType>
+	ConvexHull<T> QuickHull<T, IndexType>::getConvexHull(const Vector3<T>* vertexData, size_t vertexCount, bool CCW, bool useOriginalIndices, T epsilon) {
 		VertexDataSource<T> vertexDataSource(vertexData,vertexCount);
 		return getConvexHull(vertexDataSource,CCW,useOriginalIndices,epsilon);
 	}
 	
-	template<typename T>
-	ConvexHull<T> QuickHull<T>::getConvexHull(const T* vertexData, size_t vertexCount, bool CCW, bool useOriginalIndices, T epsilon) {
+	template<typename T, typename IndexType>
+	ConvexHull<T> QuickHull<T, IndexType>::getConvexHull(const T* vertexData, size_t vertexCount, bool CCW, bool useOriginalIndices, T epsilon) {
 		VertexDataSource<T> vertexDataSource((const vec3*)vertexData,vertexCount);
 		return getConvexHull(vertexDataSource,CCW,useOriginalIndices,epsilon);
 	}
 	
-	template<typename FloatType>
-	HalfEdgeMesh<FloatType, size_t> QuickHull<FloatType>::getConvexHullAsMesh(const FloatType* vertexData, size_t vertexCount, bool CCW, FloatType epsilon) {
+	template<typename FloatType, typename IndexType>
+	HalfEdgeMesh<FloatType, IndexType> QuickHull<FloatType, IndexType>::getConvexHullAsMesh(const FloatType* vertexData, size_t vertexCount, bool CCW, FloatType epsilon) {
 		VertexDataSource<FloatType> vertexDataSource((const vec3*)vertexData,vertexCount);
 		buildMesh(vertexDataSource, CCW, false, epsilon);
-		return HalfEdgeMesh<FloatType, size_t>(m_mesh, m_vertexData);
+		return HalfEdgeMesh<FloatType, IndexType>(m_mesh, m_vertexData);
+	}
+
+	template<typename FloatType, typename IndexType>
+	void QuickHull<FloatType, IndexType>::getConvexHullAsMesh(const FloatType* vertexData, size_t vertexCount, bool CCW, HalfEdgeMesh<FloatType, IndexType>& mesh, FloatType epsilon) {
+		VertexDataSource<FloatType> vertexDataSource((const vec3*)vertexData,vertexCount);
+		buildMesh(vertexDataSource, CCW, false, epsilon);
+		mesh.build(m_mesh, m_vertexData);
 	}
 	
-	template<typename T>
-	void QuickHull<T>::buildMesh(const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
+	template<typename T, typename IndexType>
+	void QuickHull<T, IndexType>::buildMesh(const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
 		if (pointCloud.size()==0) {
-			m_mesh = MeshBuilder<T>();
+			m_mesh = MeshBuilder<T, IndexType>();
 			return;
 		}
 		m_vertexData = pointCloud;
@@ -70,7 +89,7 @@ namespace quickhull {
 		m_planar = false; // The planar case happens when all the points appear to lie on a two dimensional subspace of R^3.
 		createConvexHalfEdgeMesh();
 		if (m_planar) {
-			const size_t extraPointIndex = m_planarPointCloudTemp.size()-1;
+			const IndexType extraPointIndex = static_cast<IndexType>(m_planarPointCloudTemp.size()-1);
 			for (auto& he : m_mesh.m_halfEdges) {
 				if (he.m_endVertex == extraPointIndex) {
 					he.m_endVertex = 0;
@@ -81,27 +100,31 @@ namespace quickhull {
 		}
 	}
 
-	template<typename T>
-	ConvexHull<T> QuickHull<T>::getConvexHull(const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
+	template<typename T, typename IndexType>
+	ConvexHull<T> QuickHull<T, IndexType>::getConvexHull(const VertexDataSource<T>& pointCloud, bool CCW, bool useOriginalIndices, T epsilon) {
 		buildMesh(pointCloud,CCW,useOriginalIndices,epsilon);
 		return ConvexHull<T>(m_mesh,m_vertexData, CCW, useOriginalIndices);
 	}
 
-	template<typename T>
-	void QuickHull<T>::createConvexHalfEdgeMesh() {
+	template<typename T, typename IndexType>
+	void QuickHull<T, IndexType>::createConvexHalfEdgeMesh() {
 		m_visibleFaces.clear();
 		m_horizonEdges.clear();
 		m_possiblyVisibleFaces.clear();
 		
+		// The point lists of the previous hull are gone along with its faces
+		m_pointListArena.reset();
+
 		// Compute base tetrahedron
 		setupInitialTetrahedron();
 		assert(m_mesh.m_faces.size()==4);
 
 		// Init face stack with those faces that have points assigned to them
 		m_faceList.clear();
-		for (size_t i=0;i < 4;i++) {
+		m_faceListFront = 0;
+		for (IndexType i=0;i < 4;i++) {
 			auto& f = m_mesh.m_faces[i];
-			if (f.m_pointsOnPositiveSide && f.m_pointsOnPositiveSide->size()>0) {
+			if (!f.m_pointsOnPositiveSide.empty()) {
 				m_faceList.push_back(i);
 				f.m_inFaceStack = 1;
 			}
@@ -109,7 +132,7 @@ namespace quickhull {
 
 		// Process faces until the face list is empty.
 		size_t iter = 0;
-		while (!m_faceList.empty()) {
+		while (m_faceListFront < m_faceList.size()) {
 			iter++;
 			if (iter == std::numeric_limits<size_t>::max()) {
 				// Visible face traversal marks visited faces with iteration counter (to mark that the face has been visited on this iteration) and the max value represents unvisited faces. At this point we have to reset iteration counter. This shouldn't be an
@@ -117,26 +140,28 @@ namespace quickhull {
 				iter = 0;
 			}
 			
-			const size_t topFaceIndex = m_faceList.front();
-			m_faceList.pop_front();
+			const IndexType topFaceIndex = m_faceList[m_faceListFront++];
+			if (m_faceListFront*2 > m_faceList.size()) {
+				m_faceList.erase(m_faceList.begin(), m_faceList.begin()+m_faceListFront);
+				m_faceListFront = 0;
+			}
 			
 			auto& tf = m_mesh.m_faces[topFaceIndex];
 			tf.m_inFaceStack = 0;
 
-			assert(!tf.m_pointsOnPositiveSide || tf.m_pointsOnPositiveSide->size()>0);
-			if (!tf.m_pointsOnPositiveSide || tf.isDisabled()) {
+			if (tf.m_pointsOnPositiveSide.empty() || tf.isDisabled()) {
 				continue;
 			}
 			
 			// Pick the most distant point to this triangle plane as the point to which we extrude
 			const vec3& activePoint = m_vertexData[tf.m_mostDistantPoint];
-			const size_t activePointIndex = tf.m_mostDistantPoint;
+			const IndexType activePointIndex = tf.m_mostDistantPoint;
 
 			// Find out the faces that have our active point on their positive side (these are the "visible faces"). The face on top of the stack of course is one of them. At the same time, we create a list of horizon edges.
 			m_horizonEdges.clear();
 			m_possiblyVisibleFaces.clear();
 			m_visibleFaces.clear();
-			m_possiblyVisibleFaces.emplace_back(topFaceIndex,std::numeric_limits<size_t>::max());
+			m_possiblyVisibleFaces.emplace_back(topFaceIndex,std::numeric_limits<IndexType>::max());
 			while (m_possiblyVisibleFaces.size()) {
 				const auto faceData = m_possiblyVisibleFaces.back();
 				m_possiblyVisibleFaces.pop_back();
@@ -180,20 +205,16 @@ namespace quickhull {
 			if (!reorderHorizonEdges(m_horizonEdges)) {
 				m_diagnostics.m_failedHorizonEdges++;
 				std::cerr << "Failed to solve horizon edge." << std::endl;
-				auto it = std::find(tf.m_pointsOnPositiveSide->begin(),tf.m_pointsOnPositiveSide->end(),activePointIndex);
-				tf.m_pointsOnPositiveSide->erase(it);
-				if (tf.m_pointsOnPositiveSide->size()==0) {
-					reclaimToIndexVectorPool(tf.m_pointsOnPositiveSide);
-				}
+				m_pointListArena.erase(tf.m_pointsOnPositiveSide,activePointIndex);
 				continue;
 			}
 
 			// Except for the horizon edges, all half edges of the visible faces can be marked as disabled. Their data slots will be reused.
 			// The faces will be disabled as well, but we need to remember the points that were on the positive side of them - therefore
-			// we save pointers to them.
+			// we save their point lists.
 			m_newFaceIndices.clear();
 			m_newHalfEdgeIndices.clear();
-			m_disabledFacePointVectors.clear();
+			m_disabledFacePointLists.clear();
 			size_t disableCounter = 0;
 			for (auto faceIndex : m_visibleFaces) {
 				auto& disabledFace = m_mesh.m_faces[faceIndex];
@@ -211,12 +232,11 @@ namespace quickhull {
 						}
 					}
 				}
-				// Disable the face, but retain pointer to the points that were on the positive side of it. We need to assign those points
+				// Disable the face, but retain the points that were on the positive side of it. We need to assign those points
 				// to the new faces we create shortly.
-				auto t = std::move(m_mesh.disableFace(faceIndex));
-				if (t) {
-					assert(t->size()); // Because we should not assign point vectors to faces unless needed...
-					m_disabledFacePointVectors.push_back(std::move(t));
+				auto t = m_mesh.disableFace(faceIndex);
+				if (!t.empty()) {
+					m_disabledFacePointLists.push_back(t);
 				}
 			}
 			if (disableCounter < horizonEdgeCount*2) {
@@ -228,19 +248,19 @@ namespace quickhull {
 			
 			// Create new faces using the edgeloop
 			for (size_t i = 0; i < horizonEdgeCount; i++) {
-				const size_t AB = m_horizonEdges[i];
+				const IndexType AB = m_horizonEdges[i];
 
 				auto horizonEdgeVertexIndices = m_mesh.getVertexIndicesOfHalfEdge(m_mesh.m_halfEdges[AB]);
-				size_t A,B,C;
+				IndexType A,B,C;
 				A = horizonEdgeVertexIndices[0];
 				B = horizonEdgeVertexIndices[1];
 				C = activePointIndex;
 
-				const size_t newFaceIndex = m_mesh.addFace();
+				const IndexType newFaceIndex = m_mesh.addFace();
 				m_newFaceIndices.push_back(newFaceIndex);
 
-				const size_t CA = m_newHalfEdgeIndices[2*i+0];
-				const size_t BC = m_newHalfEdgeIndices[2*i+1];
+				const IndexType CA = m_newHalfEdgeIndices[2*i+0];
+				const IndexType BC = m_newHalfEdgeIndices[2*i+1];
 
 				m_mesh.m_halfEdges[AB].m_next = BC;
 				m_mesh.m_halfEdges[BC].m_next = CA;
@@ -264,27 +284,22 @@ namespace quickhull {
 			}
 
 			// Assign points that were on the positive side of the disabled faces to the new faces.
-			for (auto& disabledPoints : m_disabledFacePointVectors) {
-				assert(disabledPoints);
-				for (const auto& point : *(disabledPoints)) {
-					if (point == activePointIndex) {
-						continue;
+			m_partitionPoints.clear();
+			for (auto& disabledPoints : m_disabledFacePointLists) {
+				PointListArena<IndexType>::forEach(disabledPoints, [&](IndexType point) {
+					if (point != activePointIndex) {
+						m_partitionPoints.push_back(point);
 					}
-					for (size_t j=0;j<horizonEdgeCount;j++) {
-						if (addPointToFace(m_mesh.m_faces[m_newFaceIndices[j]], point)) {
-							break;
-						}
-					}
-				}
-				// The points are no longer needed: we can move them to the vector pool for reuse.
-				reclaimToIndexVectorPool(disabledPoints);
+				});
+				// The points are no longer needed: their chunks can be reused for the new faces' points.
+				m_pointListArena.release(disabledPoints);
 			}
+			addPointsToFaces(m_newFaceIndices.data(), static_cast<IndexType>(horizonEdgeCount));
 
 			// Increase face stack size if needed
 			for (const auto newFaceIndex : m_newFaceIndices) {
 				auto& newFace = m_mesh.m_faces[newFaceIndex];
-				if (newFace.m_pointsOnPositiveSide) {
-					assert(newFace.m_pointsOnPositiveSide->size()>0);
+				if (!newFace.m_pointsOnPositiveSide.empty()) {
 					if (!newFace.m_inFaceStack) {
 						m_faceList.push_back(newFaceIndex);
 						newFace.m_inFaceStack = 1;
@@ -293,20 +308,19 @@ namespace quickhull {
 			}
 		}
 		
-		// Cleanup
-		m_indexVectorPool.clear();
+		// The arena keeps its blocks for the next hull computed with this object
 	}
 	
 	/*
 	 * Private helper functions
 	 */
 
-	template <typename T>
-	std::array<size_t,6> QuickHull<T>::getExtremeValues() {
-		std::array<size_t,6> outIndices{0,0,0,0,0,0};
+	template<typename T, typename IndexType>
+	std::array<IndexType,6> QuickHull<T, IndexType>::getExtremeValues() {
+		std::array<IndexType,6> outIndices{0,0,0,0,0,0};
 		T extremeVals[6] = {m_vertexData[0].x,m_vertexData[0].x,m_vertexData[0].y,m_vertexData[0].y,m_vertexData[0].z,m_vertexData[0].z};
-		const size_t vCount = m_vertexData.size();
-		for (size_t i=1;i<vCount;i++) {
+		const IndexType vCount = static_cast<IndexType>(m_vertexData.size());
+		for (IndexType i=1;i<vCount;i++) {
 			const Vector3<T>& pos = m_vertexData[i];
 			if (pos.x>extremeVals[0]) {
 				extremeVals[0]=pos.x;
@@ -336,14 +350,14 @@ namespace quickhull {
 		return outIndices;
 	}
 
-	template<typename T>
-	bool QuickHull<T>::reorderHorizonEdges(std::vector<size_t>& horizonEdges) {
+	template<typename T, typename IndexType>
+	bool QuickHull<T, IndexType>::reorderHorizonEdges(std::vector<IndexType>& horizonEdges) {
 		const size_t horizonEdgeCount = horizonEdges.size();
 		for (size_t i=0;i<horizonEdgeCount-1;i++) {
-			const size_t endVertex = m_mesh.m_halfEdges[ horizonEdges[i] ].m_endVertex;
+			const IndexType endVertex = m_mesh.m_halfEdges[ horizonEdges[i] ].m_endVertex;
 			bool foundNext = false;
 			for (size_t j=i+1;j<horizonEdgeCount;j++) {
-				const size_t beginVertex = m_mesh.m_halfEdges[ m_mesh.m_halfEdges[horizonEdges[j]].m_opp ].m_endVertex;
+				const IndexType beginVertex = m_mesh.m_halfEdges[ m_mesh.m_halfEdges[horizonEdges[j]].m_opp ].m_endVertex;
 				if (beginVertex == endVertex) {
 					std::swap(horizonEdges[i+1],horizonEdges[j]);
 					foundNext = true;
@@ -358,8 +372,8 @@ namespace quickhull {
 		return true;
 	}
 	
-	template <typename T>
-	T QuickHull<T>::getScale(const std::array<size_t,6>& extremeValues) {
+	template<typename T, typename IndexType>
+	T QuickHull<T, IndexType>::getScale(const std::array<IndexType,6>& extremeValues) {
 		T s = 0;
 		for (size_t i=0;i<6;i++) {
 			const T* v = (const T*)(&m_vertexData[extremeValues[i]]);
@@ -372,13 +386,13 @@ namespace quickhull {
 		return s;
 	}
 
-	template<typename T>
-	void QuickHull<T>::setupInitialTetrahedron() {
-		const size_t vertexCount = m_vertexData.size();
+	template<typename T, typename IndexType>
+	void QuickHull<T, IndexType>::setupInitialTetrahedron() {
+		const IndexType vertexCount = static_cast<IndexType>(m_vertexData.size());
 		
 		// If we have at most 4 points, just return a degenerate tetrahedron:
 		if (vertexCount <= 4) {
-			size_t v[4] = {0,std::min((size_t)1,vertexCount-1),std::min((size_t)2,vertexCount-1),std::min((size_t)3,vertexCount-1)};
+			IndexType v[4] = {0,std::min((IndexType)1,vertexCount-1),std::min((IndexType)2,vertexCount-1),std::min((IndexType)3,vertexCount-1)};
 			const Vector3<T> N = mathutils::getTriangleNormal(m_vertexData[v[0]],m_vertexData[v[1]],m_vertexData[v[2]]);
 			const Plane<T> trianglePlane(N,m_vertexData[v[0]]);
 			if (trianglePlane.isPointOnPositiveSide(m_vertexData[v[3]])) {
@@ -389,7 +403,7 @@ namespace quickhull {
 		
 		// Find two most distant extreme points.
 		T maxD = m_epsilonSquared;
-		std::pair<size_t,size_t> selectedPoints;
+		std::pair<IndexType,IndexType> selectedPoints;
 		for (size_t i=0;i<6;i++) {
 			for (size_t j=i+1;j<6;j++) {
 				const T d = m_vertexData[ m_extremeValues[i] ].getSquaredDistanceTo( m_vertexData[ m_extremeValues[j] ] );
@@ -401,16 +415,16 @@ namespace quickhull {
 		}
 		if (maxD == m_epsilonSquared) {
 			// A degenerate case: the point cloud seems to consists of a single point
-			return m_mesh.setup(0,std::min((size_t)1,vertexCount-1),std::min((size_t)2,vertexCount-1),std::min((size_t)3,vertexCount-1));
+			return m_mesh.setup(0,std::min((IndexType)1,vertexCount-1),std::min((IndexType)2,vertexCount-1),std::min((IndexType)3,vertexCount-1));
 		}
 		assert(selectedPoints.first != selectedPoints.second);
 		
 		// Find the most distant point to the line between the two chosen extreme points.
 		const Ray<T> r(m_vertexData[selectedPoints.first], (m_vertexData[selectedPoints.second] - m_vertexData[selectedPoints.first]));
 		maxD = m_epsilonSquared;
-		size_t maxI=std::numeric_limits<size_t>::max();
-		const size_t vCount = m_vertexData.size();
-		for (size_t i=0;i<vCount;i++) {
+		IndexType maxI=std::numeric_limits<IndexType>::max();
+		const IndexType vCount = static_cast<IndexType>(m_vertexData.size());
+		for (IndexType i=0;i<vCount;i++) {
 			const T distToRay = mathutils::getSquaredDistanceBetweenPointAndRay(m_vertexData[i],r);
 			if (distToRay > maxD) {
 				maxD=distToRay;
@@ -423,17 +437,17 @@ namespace quickhull {
 			auto it = std::find_if(m_vertexData.begin(),m_vertexData.end(),[&](const vec3& ve) {
 				return ve != m_vertexData[selectedPoints.first] && ve != m_vertexData[selectedPoints.second];
 			});
-			const size_t thirdPoint = (it == m_vertexData.end()) ? selectedPoints.first : std::distance(m_vertexData.begin(),it);
+			const IndexType thirdPoint = (it == m_vertexData.end()) ? selectedPoints.first : static_cast<IndexType>(std::distance(m_vertexData.begin(),it));
 			it = std::find_if(m_vertexData.begin(),m_vertexData.end(),[&](const vec3& ve) {
 				return ve != m_vertexData[selectedPoints.first] && ve != m_vertexData[selectedPoints.second] && ve != m_vertexData[thirdPoint];
 			});
-			const size_t fourthPoint = (it == m_vertexData.end()) ? selectedPoints.first : std::distance(m_vertexData.begin(),it);
+			const IndexType fourthPoint = (it == m_vertexData.end()) ? selectedPoints.first : static_cast<IndexType>(std::distance(m_vertexData.begin(),it));
 			return m_mesh.setup(selectedPoints.first,selectedPoints.second,thirdPoint,fourthPoint);
 		}
 
 		// These three points form the base triangle for our tetrahedron.
 		assert(selectedPoints.first != maxI && selectedPoints.second != maxI);
-		std::array<size_t,3> baseTriangle{selectedPoints.first, selectedPoints.second, maxI};
+		std::array<IndexType,3> baseTriangle{selectedPoints.first, selectedPoints.second, maxI};
 		const Vector3<T> baseTriangleVertices[]={ m_vertexData[baseTriangle[0]], m_vertexData[baseTriangle[1]],  m_vertexData[baseTriangle[2]] };
 		
 		// Next step is to find the 4th vertex of the tetrahedron. We naturally choose the point farthest away from the triangle plane.
@@ -441,7 +455,7 @@ namespace quickhull {
 		maxI=0;
 		const Vector3<T> N = mathutils::getTriangleNormal(baseTriangleVertices[0],baseTriangleVertices[1],baseTriangleVertices[2]);
 		Plane<T> trianglePlane(N,baseTriangleVertices[0]);
-		for (size_t i=0;i<vCount;i++) {
+		for (IndexType i=0;i<vCount;i++) {
 			const T d = std::abs(mathutils::getSignedDistanceToPlane(m_vertexData[i],trianglePlane));
 			if (d>maxD) {
 				maxD=d;
@@ -456,7 +470,7 @@ namespace quickhull {
 			m_planarPointCloudTemp.insert(m_planarPointCloudTemp.begin(),m_vertexData.begin(),m_vertexData.end());
 			const vec3 extraPoint = N + m_vertexData[0];
 			m_planarPointCloudTemp.push_back(extraPoint);
-			maxI = m_planarPointCloudTemp.size()-1;
+			maxI = static_cast<IndexType>(m_planarPointCloudTemp.size()-1);
 			m_vertexData = VertexDataSource<T>(m_planarPointCloudTemp);
 		}
 
@@ -479,20 +493,100 @@ namespace quickhull {
 		}
 
 		// Finally we assign a face for each vertex outside the tetrahedron (vertices inside the tetrahedron have no role anymore)
-		for (size_t i=0;i<vCount;i++) {
-			for (auto& face : m_mesh.m_faces) {
-				if (addPointToFace(face, i)) {
-					break;
+		m_partitionPoints.resize(vCount);
+		for (IndexType i=0;i<vCount;i++) {
+			m_partitionPoints[i] = i;
+		}
+		const IndexType faceIndices[4] = {0,1,2,3};
+		addPointsToFaces(faceIndices, 4);
+	}
+	
+	template<typename T, typename IndexType>
+	bool QuickHull<T, IndexType>::assignInParallel(size_t pointCount) const {
+#ifdef _OPENMP
+		return m_parallel && pointCount >= kMinParallelPoints && omp_get_max_threads() > 1;
+#else
+		return false;
+#endif
+	}
+
+	template<typename T, typename IndexType>
+	template<typename F>
+	void QuickHull<T, IndexType>::testPointBlock(size_t begin, size_t count, const IndexType* faceIndices, IndexType faceCount, F onPositiveSide) const {
+		// The points are copied into x, y and z arrays so that their distances to each face can be computed a whole SIMD register
+		// at a time. The points found to be on the positive side of a face are dropped from the block, the rest are tested against
+		// the next face.
+		T xs[kAssignBlockSize], ys[kAssignBlockSize], zs[kAssignBlockSize], D[kAssignBlockSize];
+		size_t slots[kAssignBlockSize];
+		for (size_t i=0;i<count;i++) {
+			const Vector3<T>& v = m_vertexData[m_partitionPoints[begin+i]];
+			xs[i] = v.x;
+			ys[i] = v.y;
+			zs[i] = v.z;
+			slots[i] = begin+i;
+		}
+		for (IndexType j=0;j<faceCount && count>0;j++) {
+			const Face& f = m_mesh.m_faces[faceIndices[j]];
+			mathutils::PlaneDistances<T>::compute(f.m_P, xs, ys, zs, count, D);
+			const T minSqrDistance = m_epsilonSquared*f.m_P.m_sqrNLength;
+			size_t remaining = 0;
+			for (size_t i=0;i<count;i++) {
+				if (D[i]>0 && D[i]*D[i] > minSqrDistance) {
+					onPositiveSide(slots[i], j, D[i]);
+				}
+				else {
+					xs[remaining] = xs[i];
+					ys[remaining] = ys[i];
+					zs[remaining] = zs[i];
+					slots[remaining] = slots[i];
+					remaining++;
 				}
 			}
+			count = remaining;
 		}
 	}
-	
+
+	template<typename T, typename IndexType>
+	void QuickHull<T, IndexType>::addPointsToFaces(const IndexType* faceIndices, IndexType faceCount) {
+		const size_t pointCount = m_partitionPoints.size();
+		if (!assignInParallel(pointCount)) {
+			// Each face gets its points in increasing order even when they are appended as soon as they are found
+			for (size_t begin=0;begin<pointCount;begin+=kAssignBlockSize) {
+				testPointBlock(begin, std::min(kAssignBlockSize, pointCount-begin), faceIndices, faceCount, [&](size_t i, IndexType j, T D) {
+					assignPointToFace(m_mesh.m_faces[faceIndices[j]], m_partitionPoints[i], D);
+				});
+			}
+			return;
+		}
+
+		// Find the face of each point on all threads, faceCount meaning none...
+		const int blockCount = static_cast<int>((pointCount + kAssignBlockSize - 1) / kAssignBlockSize);
+		m_partitionFaces.assign(pointCount, faceCount);
+		m_partitionDistances.resize(pointCount);
+		#pragma omp parallel for
+		for (int block=0;block<blockCount;block++) {
+			const size_t begin = static_cast<size_t>(block)*kAssignBlockSize;
+			testPointBlock(begin, std::min(kAssignBlockSize, pointCount-begin), faceIndices, faceCount, [&](size_t i, IndexType j, T D) {
+				m_partitionFaces[i] = j;
+				m_partitionDistances[i] = D;
+			});
+		}
+
+		// ...then append them in order, so each face gets the same point list and most distant point as on one thread
+		for (size_t i=0;i<pointCount;i++) {
+			if (m_partitionFaces[i] < faceCount) {
+				assignPointToFace(m_mesh.m_faces[faceIndices[m_partitionFaces[i]]], m_partitionPoints[i], m_partitionDistances[i]);
+			}
+		}
+	}
+
 	/*
-	 * Explicit template specifications for float and double
+	 * Explicit template specifications for float and double, with size_t and 32 bit indices
 	 */
 
 	template class QuickHull<float>;
 	template class QuickHull<double>;
+	template class QuickHull<float, std::uint32_t>;
+	template class QuickHull<double, std::uint32_t>;
 }
 
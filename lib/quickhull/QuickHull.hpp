@@ -1,12 +1,11 @@
 #ifndef QUICKHULL_HPP_
 #define QUICKHULL_HPP_
-#include <deque>
 #include <vector>
 #include <array>
 #include <limits>
 #include "Structs/Vector3.hpp"
 #include "Structs/Plane.hpp"
-#include "Structs/Pool.hpp"
+#include "Structs/PointListArena.hpp"
 #include "Structs/Mesh.hpp"
 #include "ConvexHull.hpp"
 #include "HalfEdgeMesh.hpp"
@@ -27,6 +26,13 @@
  *
  * The implementation is thread-safe if each thread is using its own QuickHull object.
  *
+ * IndexType is the type of the point, face and half edge indices the hull is built with, size_t by default. A 32 bit type
+ * makes the half edge structure half the size, which is enough for point clouds with fewer than 2^32 points.
+ *
+ * With setParallel(true), the assignment of points to faces (to the initial tetrahedron, and from the visible faces to the new ones)
+ * is spread across OpenMP threads whenever there are enough points to assign. Each point is tested in parallel and the points are then
+ * appended to their faces in the sequential order, so the hull is exactly the one the sequential path builds.
+ *
  *
  * SUMMARY OF THE ALGORITHM:
  *         - Create initial simplex (tetrahedron) using extreme points. We have four faces now and they form a convex mesh M.
@@ -59,54 +65,81 @@ namespace quickhull {
 	template<typename FloatType>
 	FloatType defaultEps();
 
-	template<typename FloatType>
+	template<typename FloatType, typename IndexType = size_t>
 	class QuickHull {
 		using vec3 = Vector3<FloatType>;
+		using Face = typename MeshBuilder<FloatType, IndexType>::Face;
+		using PointList = typename PointListArena<IndexType>::List;
 
 		FloatType m_epsilon, m_epsilonSquared, m_scale;
 		bool m_planar;
 		std::vector<vec3> m_planarPointCloudTemp;
 		VertexDataSource<FloatType> m_vertexData;
-		MeshBuilder<FloatType> m_mesh;
-		std::array<size_t,6> m_extremeValues;
+		MeshBuilder<FloatType, IndexType> m_mesh;
+		std::array<IndexType,6> m_extremeValues;
 		DiagnosticsData m_diagnostics;
 
 		// Temporary variables used during iteration process
-		std::vector<size_t> m_newFaceIndices;
-		std::vector<size_t> m_newHalfEdgeIndices;
-		std::vector< std::unique_ptr<std::vector<size_t>> > m_disabledFacePointVectors;
-		std::vector<size_t> m_visibleFaces;
-		std::vector<size_t> m_horizonEdges;
+		std::vector<IndexType> m_newFaceIndices;
+		std::vector<IndexType> m_newHalfEdgeIndices;
+		std::vector<PointList> m_disabledFacePointLists;
+		std::vector<IndexType> m_visibleFaces;
+		std::vector<IndexType> m_horizonEdges;
 		struct FaceData {
-			size_t m_faceIndex;
-			size_t m_enteredFromHalfEdge; // If the face turns out not to be visible, this half edge will be marked as horizon edge
-			FaceData(size_t fi, size_t he) : m_faceIndex(fi),m_enteredFromHalfEdge(he) {}
+			IndexType m_faceIndex;
+			IndexType m_enteredFromHalfEdge; // If the face turns out not to be visible, this half edge will be marked as horizon edge
+			FaceData(IndexType fi, IndexType he) : m_faceIndex(fi),m_enteredFromHalfEdge(he) {}
 		};
 		std::vector<FaceData> m_possiblyVisibleFaces;
-		std::deque<size_t> m_faceList;
+
+		// Faces with points on their positive side, processed first in first out. Faces are taken from the front by advancing
+		// m_faceListFront and the processed front is only erased once it makes up half of the vector, so the queue is a single
+		// contiguous block that keeps its capacity between hulls, unlike a std::deque.
+		std::vector<IndexType> m_faceList;
+		size_t m_faceListFront = 0;
+
+		// Parallel point assignment
+		bool m_parallel = false;
+		std::vector<IndexType> m_partitionPoints;
+		std::vector<IndexType> m_partitionFaces;
+		std::vector<FloatType> m_partitionDistances;
+		// Fewer points than this are assigned sequentially even in parallel mode, starting the threads would cost more
+		static const size_t kMinParallelPoints = 4096;
+		// Points are tested against the faces in blocks of this many
+		static const size_t kAssignBlockSize = 256;
 
 		// Create a half edge mesh representing the base tetrahedron from which the QuickHull iteration proceeds. m_extremeValues must be properly set up when this is called.
 		void setupInitialTetrahedron();
 
 		// Given a list of half edges, try to rearrange them so that they form a loop. Return true on success.
-		bool reorderHorizonEdges(std::vector<size_t>& horizonEdges);
+		bool reorderHorizonEdges(std::vector<IndexType>& horizonEdges);
 		
 		// Find indices of extreme values (max x, min x, max y, min y, max z, min z) for the given point cloud
-		std::array<size_t,6> getExtremeValues();
+		std::array<IndexType,6> getExtremeValues();
 		
 		// Compute scale of the vertex data.
-		FloatType getScale(const std::array<size_t,6>& extremeValues);
+		FloatType getScale(const std::array<IndexType,6>& extremeValues);
 		
-		// Each face contains a unique pointer to a vector of indices. However, many - often most - faces do not have any points on the positive
-		// side of them especially at the the end of the iteration. When a face is removed from the mesh, its associated point vector, if such
-		// exists, is moved to the index vector pool, and when we need to add new faces with points on the positive side to the mesh,
-		// we reuse these vectors. This reduces the amount of std::vectors we have to deal with, and impact on performance is remarkable.
-		Pool<std::vector<size_t>> m_indexVectorPool;
-		inline std::unique_ptr<std::vector<size_t>> getIndexVectorFromPool();
-		inline void reclaimToIndexVectorPool(std::unique_ptr<std::vector<size_t>>& ptr);
+		// The points on the positive side of each face are kept in a list allocated from this arena. Many - often most - faces do not have
+		// any points on the positive side of them especially at the the end of the iteration, and when a face is removed from the mesh, its
+		// points are reassigned and its list is released for reuse. The arena is reset for every hull and keeps its memory between hulls,
+		// so faces never allocate memory of their own.
+		PointListArena<IndexType> m_pointListArena;
 		
-		// Associates a point with a face if the point resides on the positive side of the plane. Returns true if the points was on the positive side.
-		inline bool addPointToFace(typename MeshBuilder<FloatType>::Face& f, size_t pointIndex);
+		// Appends a point at the given distance on the positive side of the face to the face's points
+		inline void assignPointToFace(Face& f, IndexType pointIndex, FloatType D);
+
+		// Whether assigning this many points to faces is worth spreading across threads
+		bool assignInParallel(size_t pointCount) const;
+
+		// Associates each point of m_partitionPoints with the first of the given faces it resides on the positive side of. The
+		// distances are computed with SIMD, and on all threads if assignInParallel allows it.
+		void addPointsToFaces(const IndexType* faceIndices, IndexType faceCount);
+
+		// Tests the count points of m_partitionPoints starting at begin against the given faces in order, calling
+		// onPositiveSide(i, j, D) for each point i on the positive side of face j at distance D, with the first such face only
+		template<typename F>
+		void testPointBlock(size_t begin, size_t count, const IndexType* faceIndices, IndexType faceCount, F onPositiveSide) const;
 		
 		// This will update m_mesh from which we create the ConvexHull object that getConvexHull function returns
 		void createConvexHalfEdgeMesh();
@@ -167,11 +200,24 @@ namespace quickhull {
 		//   eps: minimum distance to a plane to consider a point being on positive side of it (for a point cloud with scale 1)
 		// Returns:
 		//   Convex hull of the point cloud as a mesh object with half edge structure.
-		HalfEdgeMesh<FloatType, size_t> getConvexHullAsMesh(const FloatType* vertexData,
+		HalfEdgeMesh<FloatType, IndexType> getConvexHullAsMesh(const FloatType* vertexData,
 															size_t vertexCount,
 															bool CCW,
 															FloatType eps = defaultEps<FloatType>());
+
+		// Same as above, but builds the half edge mesh into the given one, reusing the capacity of its vectors. Together with the
+		// buffers this object keeps between calls, computing hulls of similar size over and over allocates little to no memory.
+		void getConvexHullAsMesh(const FloatType* vertexData,
+								 size_t vertexCount,
+								 bool CCW,
+								 HalfEdgeMesh<FloatType, IndexType>& mesh,
+								 FloatType eps = defaultEps<FloatType>());
 		
+		// Spread the assignment of points to faces across threads (off by default). The resulting hull is the same either way.
+		void setParallel(bool parallel) {
+			m_parallel = parallel;
+		}
+
 		// Get diagnostics about last generated convex hull
 		const DiagnosticsData& getDiagnostics() {
 			return m_diagnostics;
@@ -182,39 +228,13 @@ namespace quickhull {
 	 * Inline function definitions
 	 */
 	
-	template<typename T>
-	std::unique_ptr<std::vector<size_t>> QuickHull<T>::getIndexVectorFromPool() {
-		auto r = std::move(m_indexVectorPool.get());
-		r->clear();
-		return r;
-	}
-	
-	template<typename T>
-	void QuickHull<T>::reclaimToIndexVectorPool(std::unique_ptr<std::vector<size_t>>& ptr) {
-		const size_t oldSize = ptr->size();
-		if ((oldSize+1)*128 < ptr->capacity()) {
-			// Reduce memory usage! Huge vectors are needed at the beginning of iteration when faces have many points on their positive side. Later on, smaller vectors will suffice.
-			ptr.reset(nullptr);
-			return;
-		}
-		m_indexVectorPool.reclaim(ptr);
-	}
-
-	template<typename T>
-	bool QuickHull<T>::addPointToFace(typename MeshBuilder<T>::Face& f, size_t pointIndex) {
-		const T D = mathutils::getSignedDistanceToPlane(m_vertexData[ pointIndex ],f.m_P);
-		if (D>0 && D*D > m_epsilonSquared*f.m_P.m_sqrNLength) {
-			if (!f.m_pointsOnPositiveSide) {
-				f.m_pointsOnPositiveSide = std::move(getIndexVectorFromPool());
-			}
-			f.m_pointsOnPositiveSide->push_back( pointIndex );
-			if (D > f.m_mostDistantPointDist) {
-				f.m_mostDistantPointDist = D;
-				f.m_mostDistantPoint = pointIndex;
-			}
-			return true;
+	template<typename T, typename IndexType>
+	void QuickHull<T, IndexType>::assignPointToFace(Face& f, IndexType pointIndex, T D) {
+		m_pointListArena.append(f.m_pointsOnPositiveSide, pointIndex);
+		if (D > f.m_mostDistantPointDist) {
+			f.m_mostDistantPointDist = D;
+			f.m_mostDistantPoint = pointIndex;
 		}
-		return false;
 	}
 
 }
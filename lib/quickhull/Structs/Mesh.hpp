@@ -4,7 +4,7 @@
 #include <vector>
 #include "Vector3.hpp"
 #include "Plane.hpp"
-#include "Pool.hpp"
+#include "PointListArena.hpp"
 #include <array>
 #include <cassert>
 #include <limits>
@@ -14,36 +14,38 @@
 
 namespace quickhull {
 
-	template <typename T>
+	// IndexType is used for all vertex, half edge and face indices. A 32 bit type halves the size of the half edges compared to
+	// size_t and is enough for any point cloud with fewer than 2^32 points.
+	template <typename T, typename IndexType = size_t>
 	class MeshBuilder {
 	public:
 		struct HalfEdge {
-			size_t m_endVertex;
-			size_t m_opp;
-			size_t m_face;
-			size_t m_next;
+			IndexType m_endVertex;
+			IndexType m_opp;
+			IndexType m_face;
+			IndexType m_next;
 			
 			void disable() {
-				m_endVertex = std::numeric_limits<size_t>::max();
+				m_endVertex = std::numeric_limits<IndexType>::max();
 			}
 			
 			bool isDisabled() const {
-				return m_endVertex == std::numeric_limits<size_t>::max();
+				return m_endVertex == std::numeric_limits<IndexType>::max();
 			}
 		};
 
 		struct Face {
-			size_t m_he;
+			IndexType m_he;
 			Plane<T> m_P;
 			T m_mostDistantPointDist;
-			size_t m_mostDistantPoint;
+			IndexType m_mostDistantPoint;
 			size_t m_visibilityCheckedOnIteration;
 			std::uint8_t m_isVisibleFaceOnCurrentIteration : 1;
 			std::uint8_t m_inFaceStack : 1;
 			std::uint8_t m_horizonEdgesOnCurrentIteration : 3; // Bit for each half edge assigned to this face, each being 0 or 1 depending on whether the edge belongs to horizon edge
-			std::unique_ptr<std::vector<size_t>> m_pointsOnPositiveSide;
+			typename PointListArena<IndexType>::List m_pointsOnPositiveSide;
 
-			Face() : m_he(std::numeric_limits<size_t>::max()),
+			Face() : m_he(std::numeric_limits<IndexType>::max()),
 					 m_mostDistantPointDist(0),
 					 m_mostDistantPoint(0),
 					 m_visibilityCheckedOnIteration(0),
@@ -55,11 +57,11 @@ namespace quickhull {
 			}
 			
 			void disable() {
-				m_he = std::numeric_limits<size_t>::max();
+				m_he = std::numeric_limits<IndexType>::max();
 			}
 
 			bool isDisabled() const {
-				return m_he == std::numeric_limits<size_t>::max();
+				return m_he == std::numeric_limits<IndexType>::max();
 			}
 		};
 
@@ -70,41 +72,43 @@ namespace quickhull {
 		// When the mesh is modified and faces and half edges are removed from it, we do not actually remove them from the container vectors.
 		// Insted, they are marked as disabled which means that the indices can be reused when we need to add new faces and half edges to the mesh.
 		// We store the free indices in the following vectors.
-		std::vector<size_t> m_disabledFaces,m_disabledHalfEdges;
+		std::vector<IndexType> m_disabledFaces,m_disabledHalfEdges;
 		
-		size_t addFace() {
+		IndexType addFace() {
 			if (m_disabledFaces.size()) {
-				size_t index = m_disabledFaces.back();
+				IndexType index = m_disabledFaces.back();
 				auto& f = m_faces[index];
 				assert(f.isDisabled());
-				assert(!f.m_pointsOnPositiveSide);
+				assert(f.m_pointsOnPositiveSide.empty());
 				f.m_mostDistantPointDist = 0;
 				m_disabledFaces.pop_back();
 				return index;
 			}
 			m_faces.emplace_back();
-			return m_faces.size()-1;
+			return static_cast<IndexType>(m_faces.size()-1);
 		}
 
-		size_t addHalfEdge()	{
+		IndexType addHalfEdge()	{
 			if (m_disabledHalfEdges.size()) {
-				const size_t index = m_disabledHalfEdges.back();
+				const IndexType index = m_disabledHalfEdges.back();
 				m_disabledHalfEdges.pop_back();
 				return index;
 			}
 			m_halfEdges.emplace_back();
-			return m_halfEdges.size()-1;
+			return static_cast<IndexType>(m_halfEdges.size()-1);
 		}
 
-		// Mark a face as disabled and return a pointer to the points that were on the positive of it.
-		std::unique_ptr<std::vector<size_t>> disableFace(size_t faceIndex) {
+		// Mark a face as disabled and return the list of the points that were on the positive of it.
+		typename PointListArena<IndexType>::List disableFace(IndexType faceIndex) {
 			auto& f = m_faces[faceIndex];
 			f.disable();
 			m_disabledFaces.push_back(faceIndex);
-			return std::move(f.m_pointsOnPositiveSide);
+			auto points = f.m_pointsOnPositiveSide;
+			f.m_pointsOnPositiveSide = typename PointListArena<IndexType>::List();
+			return points;
 		}
 
-		void disableHalfEdge(size_t heIndex) {
+		void disableHalfEdge(IndexType heIndex) {
 			auto& he = m_halfEdges[heIndex];
 			he.disable();
 			m_disabledHalfEdges.push_back(heIndex);
@@ -113,7 +117,7 @@ namespace quickhull {
 		MeshBuilder() = default;
 		
 		// Create a mesh with initial tetrahedron ABCD. Dot product of AB with the normal of triangle ABC should be negative.
-		void setup(size_t a, size_t b, size_t c, size_t d) {
+		void setup(IndexType a, IndexType b, IndexType c, IndexType d) {
 			m_faces.clear();
 			m_halfEdges.clear();
 			m_disabledFaces.clear();
@@ -225,8 +229,8 @@ namespace quickhull {
 			m_faces.push_back(std::move(CBD));
 		}
 
-		std::array<size_t,3> getVertexIndicesOfFace(const Face& f) const {
-			std::array<size_t,3> v;
+		std::array<IndexType,3> getVertexIndicesOfFace(const Face& f) const {
+			std::array<IndexType,3> v;
 			const HalfEdge* he = &m_halfEdges[f.m_he];
 			v[0] = he->m_endVertex;
 			he = &m_halfEdges[he->m_next];
@@ -236,11 +240,11 @@ namespace quickhull {
 			return v;
 		}
 
-		std::array<size_t,2> getVertexIndicesOfHalfEdge(const HalfEdge& he) const {
+		std::array<IndexType,2> getVertexIndicesOfHalfEdge(const HalfEdge& he) const {
 			return {m_halfEdges[he.m_opp].m_endVertex,he.m_endVertex};
 		}
 
-		std::array<size_t,3> getHalfEdgeIndicesOfFace(const Face& f) const {
+		std::array<IndexType,3> getHalfEdgeIndicesOfFace(const Face& f) const {
 			return {f.m_he,m_halfEdges[f.m_he].m_next,m_halfEdges[m_halfEdges[f.m_he].m_next].m_next};
 		}
 	};
@@ -0,0 +1,198 @@
+#ifndef PointListArena_h
+#define PointListArena_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace quickhull {
+
+	// Lists of point indices, one for each face with points on its positive side, carved out of a few large blocks instead of
+	// allocating a vector per face. A list is a chain of chunks whose capacities double up to a limit as points are appended, so
+	// appending never copies points. Chunks of released lists are recycled by capacity, and reset() makes the whole arena
+	// available again for the next hull while keeping the blocks allocated.
+	template<typename IndexType>
+	class PointListArena {
+		struct Chunk {
+			Chunk* m_next;
+			std::uint32_t m_size;
+			std::uint32_t m_sizeClass; // The chunk holds kMinChunkPoints << m_sizeClass points
+
+			IndexType* points() {
+				return reinterpret_cast<IndexType*>(this+1);
+			}
+
+			const IndexType* points() const {
+				return reinterpret_cast<const IndexType*>(this+1);
+			}
+
+			std::uint32_t capacity() const {
+				return kMinChunkPoints << m_sizeClass;
+			}
+		};
+
+		static const std::uint32_t kMinChunkPoints = 8;
+		static const std::uint32_t kSizeClasses = 11; // Up to 8192 points per chunk
+		static const size_t kBlockSize = 1 << 18;
+
+		std::vector<std::unique_ptr<char[]>> m_blocks;
+		size_t m_block = 0; // Block chunks are currently cut from, and the offset of its free space
+		size_t m_blockOffset = 0;
+		Chunk* m_freeChunks[kSizeClasses] = {};
+
+		static size_t chunkBytes(std::uint32_t sizeClass) {
+			return sizeof(Chunk) + sizeof(IndexType)*(size_t(kMinChunkPoints) << sizeClass);
+		}
+
+		Chunk* allocateChunk(std::uint32_t sizeClass) {
+			Chunk* c = m_freeChunks[sizeClass];
+			if (c) {
+				m_freeChunks[sizeClass] = c->m_next;
+			}
+			else {
+				const size_t bytes = chunkBytes(sizeClass);
+				if (m_blocks.empty() || m_blockOffset + bytes > kBlockSize) {
+					if (!m_blocks.empty()) {
+						m_block++;
+					}
+					if (m_block == m_blocks.size()) {
+						m_blocks.emplace_back(new char[kBlockSize]);
+					}
+					m_blockOffset = 0;
+				}
+				c = reinterpret_cast<Chunk*>(m_blocks[m_block].get() + m_blockOffset);
+				m_blockOffset += bytes;
+				c->m_sizeClass = sizeClass;
+			}
+			c->m_next = nullptr;
+			c->m_size = 0;
+			return c;
+		}
+
+		void freeChunk(Chunk* c) {
+			c->m_next = m_freeChunks[c->m_sizeClass];
+			m_freeChunks[c->m_sizeClass] = c;
+		}
+
+	public:
+		// The points of one face. An empty list has no chunks.
+		struct List {
+			Chunk* m_first = nullptr;
+			Chunk* m_last = nullptr;
+
+			bool empty() const {
+				return m_first == nullptr;
+			}
+		};
+
+		PointListArena() = default;
+		PointListArena(const PointListArena&) = delete;
+		PointListArena& operator=(const PointListArena&) = delete;
+
+		// Forget all lists. Lists handed out before are invalid afterwards.
+		void reset() {
+			m_block = 0;
+			m_blockOffset = 0;
+			for (auto& c : m_freeChunks) {
+				c = nullptr;
+			}
+		}
+
+		void append(List& list, IndexType point) {
+			if (!list.m_last) {
+				list.m_first = list.m_last = allocateChunk(0);
+			}
+			else if (list.m_last->m_size == list.m_last->capacity()) {
+				const std::uint32_t sizeClass = list.m_last->m_sizeClass + 1 < kSizeClasses ? list.m_last->m_sizeClass + 1 : list.m_last->m_sizeClass;
+				list.m_last->m_next = allocateChunk(sizeClass);
+				list.m_last = list.m_last->m_next;
+			}
+			list.m_last->points()[list.m_last->m_size++] = point;
+		}
+
+		// Give the chunks of the list back to the arena, leaving the list empty
+		void release(List& list) {
+			Chunk* c = list.m_first;
+			while (c) {
+				Chunk* next = c->m_next;
+				freeChunk(c);
+				c = next;
+			}
+			list = List();
+		}
+
+		// Remove a point from the list, keeping the order of the others. The point must be in the list.
+		void erase(List& list, IndexType point) {
+			Chunk* c = list.m_first;
+			std::uint32_t i = 0;
+			while (c->points()[i] != point) {
+				if (++i == c->m_size) {
+					c = c->m_next;
+					i = 0;
+				}
+				assert(c);
+			}
+			// Every chunk but the last is full, so shifting the rest of the points down one keeps it that way
+			for (;;) {
+				if (i+1 < c->m_size) {
+					c->points()[i] = c->points()[i+1];
+					i++;
+				}
+				else if (c->m_next) {
+					c->points()[i] = c->m_next->points()[0];
+					c = c->m_next;
+					i = 0;
+				}
+				else {
+					break;
+				}
+			}
+			if (--c->m_size == 0) {
+				if (c == list.m_first) {
+					release(list);
+					return;
+				}
+				Chunk* previous = list.m_first;
+				while (previous->m_next != c) {
+					previous = previous->m_next;
+				}
+				previous->m_next = nullptr;
+				list.m_last = previous;
+				freeChunk(c);
+			}
+		}
+
+		static size_t size(const List& list) {
+			size_t s = 0;
+			for (const Chunk* c = list.m_first; c; c = c->m_next) {
+				s += c->m_size;
+			}
+			return s;
+		}
+
+		// Calls f with every point of the list, in the order they were appended
+		template<typename F>
+		static void forEach(const List& list, F f) {
+			for (const Chunk* c = list.m_first; c; c = c->m_next) {
+				const IndexType* points = c->points();
+				for (std::uint32_t i=0;i<c->m_size;i++) {
+					f(points[i]);
+				}
+			}
+		}
+	};
+
+	template<typename IndexType>
+	const std::uint32_t PointListArena<IndexType>::kMinChunkPoints;
+
+	template<typename IndexType>
+	const std::uint32_t PointListArena<IndexType>::kSizeClasses;
+
+	template<typename IndexType>
+	const size_t PointListArena<IndexType>::kBlockSize;
+
+}
+
+#endif /* PointListArena_h */
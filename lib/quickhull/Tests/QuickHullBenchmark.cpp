@@ -0,0 +1,126 @@
+#include "../QuickHull.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+// Times the sequential hull against the parallel point assignment, and size_t indices against 32 bit ones, on random points on
+// the unit sphere, where every point is on the hull, and in the unit ball, where most points are discarded early. For the index
+// types the peak heap usage of computing a hull with a new QuickHull object is reported as well.
+
+// Every allocation is prefixed with its size so the live heap size and its peak can be tracked
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static const size_t kHeaderSize = 16;
+
+void* operator new(size_t size) {
+	char* p = static_cast<char*>(std::malloc(size + kHeaderSize));
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	*reinterpret_cast<size_t*>(p) = size;
+	liveBytes += size;
+	peakBytes = std::max(peakBytes, liveBytes);
+	return p + kHeaderSize;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr) {
+		char* p = static_cast<char*>(ptr) - kHeaderSize;
+		liveBytes -= *reinterpret_cast<size_t*>(p);
+		std::free(p);
+	}
+}
+
+namespace quickhull {
+
+	namespace benchmark {
+
+		using FloatType = float;
+		using vec3 = Vector3<FloatType>;
+
+		static std::vector<vec3> randomPoints(size_t count, bool onSphere, std::mt19937& rng) {
+			std::uniform_real_distribution<FloatType> dist(-1,1);
+			std::vector<vec3> pc;
+			pc.reserve(count);
+			while (pc.size() < count) {
+				vec3 p(dist(rng),dist(rng),dist(rng));
+				const FloatType l = p.getLength();
+				if (l > 0.01f && l <= 1) {
+					pc.push_back(onSphere ? p*(1/l) : p);
+				}
+			}
+			return pc;
+		}
+
+		// Best wall time of the runs, in milliseconds
+		template<typename QH>
+		static double bestTime(QH& qh, const std::vector<vec3>& pc, size_t repeat, size_t& faceCount) {
+			double best = 0;
+			for (size_t i=0;i<repeat;i++) {
+				auto start = std::chrono::steady_clock::now();
+				auto mesh = qh.getConvexHullAsMesh(&pc[0].x, pc.size(), false, 0.000001f);
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+				faceCount = mesh.m_faces.size();
+				if (i == 0 || elapsed.count() < best) {
+					best = elapsed.count();
+				}
+			}
+			return best;
+		}
+
+		// Heap usage at the peak of computing a hull with a new QuickHull object, in MiB
+		template<typename IndexType>
+		static double peakMiB(const std::vector<vec3>& pc) {
+			const size_t liveBefore = liveBytes;
+			peakBytes = liveBytes;
+			{
+				QuickHull<FloatType, IndexType> qh;
+				auto mesh = qh.getConvexHullAsMesh(&pc[0].x, pc.size(), false, 0.000001f);
+			}
+			return (peakBytes - liveBefore) / (1024.0 * 1024.0);
+		}
+
+		int run() {
+			std::mt19937 rng(8675309);
+			const size_t repeat = 5;
+			for (size_t count : {10000, 100000, 1000000}) {
+				for (bool onSphere : {true, false}) {
+					auto pc = randomPoints(count, onSphere, rng);
+					QuickHull<FloatType> sequential;
+					QuickHull<FloatType> parallel;
+					parallel.setParallel(true);
+					size_t sequentialFaces = 0, parallelFaces = 0;
+					const double sequentialMs = bestTime(sequential, pc, repeat, sequentialFaces);
+					const double parallelMs = bestTime(parallel, pc, repeat, parallelFaces);
+					std::cout << count << " points " << (onSphere ? "on the sphere" : "in the ball") << ": sequential " << sequentialMs
+							  << " ms, parallel " << parallelMs << " ms (" << sequentialFaces << " / " << parallelFaces << " faces)" << std::endl;
+					if (sequentialFaces != parallelFaces) {
+						std::cerr << "The parallel hull differs from the sequential one." << std::endl;
+						return 1;
+					}
+
+					QuickHull<FloatType, std::uint32_t> compact;
+					size_t compactFaces = 0;
+					const double compactMs = bestTime(compact, pc, repeat, compactFaces);
+					std::cout << "    size_t indices " << sequentialMs << " ms, " << peakMiB<size_t>(pc) << " MiB peak; 32 bit indices "
+							  << compactMs << " ms, " << peakMiB<std::uint32_t>(pc) << " MiB peak" << std::endl;
+					if (sequentialFaces != compactFaces) {
+						std::cerr << "The hull with 32 bit indices differs from the size_t one." << std::endl;
+						return 1;
+					}
+				}
+			}
+			return 0;
+		}
+
+	}
+}
+
+int main(int, char**) {
+	return quickhull::benchmark::run();
+}
@@ -1,5 +1,6 @@
 #include "../QuickHull.hpp"
 #include "../MathUtils.hpp"
+#include <algorithm>
 #include <iostream>
 #include <random>
 #include <cassert>
@@ -177,6 +178,107 @@ namespace quickhull {
 			assertSameValue(dot, -1);
 		}
 
+		static void testParallel() {
+			// Enough points on the unit sphere for the parallel point assignment to kick in: the hull must be the same as the sequential one
+			std::vector<vec3> pc;
+			for (size_t i=0;i<50000;i++) {
+				vec3 p(rnd(-1,1),rnd(-1,1),rnd(-1,1));
+				if (p.getLengthSquared() > 0.01f) {
+					pc.push_back(p*(1/p.getLength()));
+				}
+			}
+			QuickHull<FloatType> sequential;
+			QuickHull<FloatType> parallel;
+			parallel.setParallel(true);
+			auto hull = sequential.getConvexHull(pc,true,false);
+			auto parallelHull = parallel.getConvexHull(pc,true,false);
+			assert(hull.getIndexBuffer() == parallelHull.getIndexBuffer());
+			assert(hull.getVertexBuffer().size() == parallelHull.getVertexBuffer().size());
+		}
+		
+		static void testPointListArena() {
+			// Lists spanning several chunks must keep their points in order through appends, erases and chunk reuse
+			PointListArena<size_t> arena;
+			for (size_t round=0;round<2;round++) {
+				arena.reset();
+				PointListArena<size_t>::List a, b;
+				std::vector<size_t> expectedA, expectedB;
+				for (size_t i=0;i<1000;i++) {
+					arena.append(a,i);
+					expectedA.push_back(i);
+					if (i%3==0) {
+						arena.append(b,i);
+						expectedB.push_back(i);
+					}
+				}
+				for (size_t point : {size_t(0), size_t(7), size_t(8), size_t(500), size_t(999)}) {
+					arena.erase(a,point);
+					expectedA.erase(std::find(expectedA.begin(),expectedA.end(),point));
+				}
+				std::vector<size_t> points;
+				PointListArena<size_t>::forEach(a,[&](size_t p) { points.push_back(p); });
+				assert(points == expectedA);
+				assert(PointListArena<size_t>::size(a) == expectedA.size());
+				arena.release(a);
+				assert(a.empty());
+				for (size_t i=0;i<100;i++) {
+					arena.append(a,i);
+				}
+				points.clear();
+				PointListArena<size_t>::forEach(b,[&](size_t p) { points.push_back(p); });
+				assert(points == expectedB);
+				PointListArena<size_t>::List c;
+				arena.append(c,42);
+				arena.erase(c,42);
+				assert(c.empty());
+			}
+		}
+		
+		static void testIndexType() {
+			// 32 bit indices must give the same hull as size_t ones, including the planar case
+			for (bool planar : {false, true}) {
+				std::vector<vec3> pc;
+				for (size_t i=0;i<10000;i++) {
+					pc.emplace_back(rnd(-1,1),rnd(-1,1),planar ? 0 : rnd(-1,1));
+				}
+				QuickHull<FloatType> wide;
+				QuickHull<FloatType,std::uint32_t> compact;
+				auto hull = wide.getConvexHull(pc,true,false);
+				auto compactHull = compact.getConvexHull(pc,true,false);
+				assert(hull.getIndexBuffer() == compactHull.getIndexBuffer());
+				auto mesh = wide.getConvexHullAsMesh(&pc[0].x,pc.size(),true);
+				auto compactMesh = compact.getConvexHullAsMesh(&pc[0].x,pc.size(),true);
+				assert(mesh.m_halfEdges.size() == compactMesh.m_halfEdges.size());
+				for (size_t i=0;i<mesh.m_halfEdges.size();i++) {
+					assert(mesh.m_halfEdges[i].m_endVertex == compactMesh.m_halfEdges[i].m_endVertex);
+					assert(mesh.m_halfEdges[i].m_opp == compactMesh.m_halfEdges[i].m_opp);
+				}
+			}
+		}
+		
+		static void testMeshReuse() {
+			// One QuickHull and one output mesh reused for different point clouds must give the same meshes as fresh objects
+			QuickHull<FloatType> reused;
+			HalfEdgeMesh<FloatType,size_t> mesh;
+			for (size_t n : {2000, 500, 3000}) {
+				std::vector<vec3> pc;
+				for (size_t i=0;i<n;i++) {
+					pc.emplace_back(rnd(-1,1),rnd(-1,1),rnd(-1,1));
+				}
+				reused.getConvexHullAsMesh(&pc[0].x,pc.size(),true,mesh);
+				QuickHull<FloatType> fresh;
+				auto expected = fresh.getConvexHullAsMesh(&pc[0].x,pc.size(),true);
+				assert(mesh.m_vertices.size() == expected.m_vertices.size());
+				assert(mesh.m_faces.size() == expected.m_faces.size());
+				assert(mesh.m_halfEdges.size() == expected.m_halfEdges.size());
+				for (size_t i=0;i<mesh.m_halfEdges.size();i++) {
+					assert(mesh.m_halfEdges[i].m_endVertex == expected.m_halfEdges[i].m_endVertex);
+					assert(mesh.m_halfEdges[i].m_opp == expected.m_halfEdges[i].m_opp);
+					assert(mesh.m_halfEdges[i].m_next == expected.m_halfEdges[i].m_next);
+				}
+			}
+		}
+		
 		int run() {
 			// Setup test env
 			const size_t N = 200;
@@ -295,6 +397,10 @@ namespace quickhull {
 			testVector3();
 			testHalfEdgeOutput();
 			sphereTest();
+			testParallel();
+			testMeshReuse();
+			testIndexType();
+			testPointListArena();
 			std::cout << "QuickHull tests succesfully passed." << std::endl;
 			return 0;
 		}
@@ -0,0 +1,37 @@
+#include "allocation_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> allocation_count(0);
+static std::atomic<size_t> allocation_bytes(0);
+
+void* operator new(size_t size)
+{
+	allocation_count++;
+	allocation_bytes += size;
+	if (void* p = std::malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+size_t allocationCount()
+{
+	return allocation_count;
+}
+
+size_t allocationBytes()
+{
+	return allocation_bytes;
+}
@@ -0,0 +1,12 @@
+#ifndef ALLOCATION_STATS_H
+#define ALLOCATION_STATS_H
+
+#include <cstddef>
+
+// Heap allocations made through operator new by the whole program. Only
+// counted in executables that link allocation_stats.cc, which replaces the
+// global operator new.
+size_t allocationCount();
+size_t allocationBytes();
+
+#endif
@@ -0,0 +1,54 @@
+#include "biome.h"
+#include "config.h"
+
+#include <cmath>
+
+namespace {
+
+// get_snow_color() in planet.frag: snow at the extremes of elevation or latitude
+glm::vec3 snowColor(float normalized_elevation, float latitude, const BiomeParams& biome)
+{
+	float snow = std::pow(normalized_elevation, 14.0f) * 175.0f + std::pow(latitude, 16.0f);
+	return biome.snow_color * glm::clamp(snow, 0.0f, 1.0f);
+}
+
+// get_coast_vegetation_color() in planet.frag: a steep sigmoid from coast to
+// vegetation just above the ocean
+glm::vec3 coastVegetationColor(float normalized_elevation, const BiomeParams& biome)
+{
+	float coast_t = 1.0f / (1.0f + std::pow(10e15f, -normalized_elevation + 0.02f));
+	return glm::mix(biome.coast_color, biome.vegetation_color, coast_t);
+}
+
+}
+
+float BiomeParams::maxElevation() const
+{
+	return (1.0f / elevation_divisor) + (1.0f - ocean_height);
+}
+
+float oceanHeight(int height_param)
+{
+	return 1.0f + ((height_param / 1000.0f) - 0.1f);
+}
+
+float vertexElevation(const glm::vec3& vertex, const BiomeParams& biome)
+{
+	return glm::length(vertex) - biome.ocean_height;
+}
+
+glm::vec3 biomeColor(const glm::vec3& vertex, const BiomeParams& biome)
+{
+	float elevation = vertexElevation(vertex, biome);
+	// On the unit sphere the latitude is just |y|
+	float latitude = std::abs(vertex.y);
+
+	glm::vec3 color;
+	if (elevation < 0.0f) {
+		color = biome.ocean_color + snowColor(0.0f, latitude, biome) / 5.0f;
+	} else {
+		float normalized_elevation = elevation / biome.maxElevation();
+		color = snowColor(normalized_elevation, latitude, biome) + coastVegetationColor(normalized_elevation, biome);
+	}
+	return glm::clamp(color, 0.0f, 1.0f);
+}
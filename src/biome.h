@@ -0,0 +1,31 @@
+#ifndef BIOME_H
+#define BIOME_H
+
+#include <glm/glm.hpp>
+
+// Ocean height for the --ocean_ht option, between 0 (everything terrain) and
+// 200 (everything underwater)
+float oceanHeight(int height_param);
+
+// What planet.vert and planet.frag color the surface with, i.e. their
+// uniforms. The defaults are those of the planets program's options.
+struct BiomeParams {
+	// Radius of the ocean surface
+	float ocean_height = oceanHeight(120);
+
+	glm::vec3 ocean_color = glm::vec3(0x1a, 0x1a, 0x66) / 255.0f;
+	glm::vec3 snow_color = glm::vec3(1.0f);
+	glm::vec3 coast_color = glm::vec3(0xed, 0xd6, 0x40) / 255.0f;
+	glm::vec3 vegetation_color = glm::vec3(0x00, 0x66, 0x00) / 255.0f;
+
+	// The max_elevation uniform: the highest a vertex can be above the ocean
+	float maxElevation() const;
+};
+
+// Height of a vertex above the ocean surface, negative under water
+float vertexElevation(const glm::vec3& vertex, const BiomeParams& biome);
+
+// The color planet.frag gives a fragment at the vertex, between 0 and 1
+glm::vec3 biomeColor(const glm::vec3& vertex, const BiomeParams& biome);
+
+#endif
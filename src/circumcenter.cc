@@ -0,0 +1,154 @@
+#include "circumcenter.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CIRCUMCENTER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CIRCUMCENTER_SSE2
+#endif
+
+// The SIMD paths do the same operations in the same order as this, so every
+// path gives bit-identical vertices
+glm::vec3 circumcenter(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	glm::vec3 e1(b - a);
+	glm::vec3 e2(c - a);
+	glm::vec3 normal(e1.y * e2.z - e1.z * e2.y,
+	                 e1.z * e2.x - e1.x * e2.z,
+	                 e1.x * e2.y - e1.y * e2.x);
+
+	// Hull triangles may wind either way, so face the normal away from the origin
+	glm::vec3 sum(a + b + c);
+	if (normal.x * sum.x + normal.y * sum.y + normal.z * sum.z < 0.0f)
+		normal = -normal;
+
+	float inv_length = 1.0f / std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+	return normal * inv_length;
+}
+
+#if defined(CIRCUMCENTER_AVX2)
+
+const char* circumcenterInstructionSet() { return "AVX2"; }
+
+namespace {
+
+const size_t kLanes = 8;
+typedef __m256 Lane;
+
+inline Lane load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+inline Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+inline Lane divide(Lane a, Lane b) { return _mm256_div_ps(a, b); }
+inline Lane squareRoot(Lane a) { return _mm256_sqrt_ps(a); }
+inline Lane set1(float f) { return _mm256_set1_ps(f); }
+inline Lane lessThan(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Lane bitAnd(Lane a, Lane b) { return _mm256_and_ps(a, b); }
+inline Lane bitXor(Lane a, Lane b) { return _mm256_xor_ps(a, b); }
+
+}
+
+#elif defined(CIRCUMCENTER_SSE2)
+
+const char* circumcenterInstructionSet() { return "SSE2"; }
+
+namespace {
+
+const size_t kLanes = 4;
+typedef __m128 Lane;
+
+inline Lane load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm_storeu_ps(p, v); }
+inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+inline Lane divide(Lane a, Lane b) { return _mm_div_ps(a, b); }
+inline Lane squareRoot(Lane a) { return _mm_sqrt_ps(a); }
+inline Lane set1(float f) { return _mm_set1_ps(f); }
+inline Lane lessThan(Lane a, Lane b) { return _mm_cmplt_ps(a, b); }
+inline Lane bitAnd(Lane a, Lane b) { return _mm_and_ps(a, b); }
+inline Lane bitXor(Lane a, Lane b) { return _mm_xor_ps(a, b); }
+
+}
+
+#else
+
+const char* circumcenterInstructionSet() { return "scalar"; }
+
+#endif
+
+#if defined(CIRCUMCENTER_AVX2) || defined(CIRCUMCENTER_SSE2)
+
+void circumcenters(const glm::vec3* points, const glm::uvec3* triangles, size_t count, glm::vec3* out)
+{
+	size_t simd_count = count - count % kLanes;
+	const Lane zero = set1(0.0f);
+	const Lane one = set1(1.0f);
+	const Lane sign_bit = set1(-0.0f);
+
+	for (size_t i = 0; i < simd_count; i += kLanes)
+	{
+		// Gather the corners of kLanes triangles into one lane per component
+		alignas(32) float corners[9][kLanes];
+		for (size_t k = 0; k < kLanes; k++)
+		{
+			const glm::uvec3& tri = triangles[i + k];
+			for (int v = 0; v < 3; v++)
+			{
+				const glm::vec3& p = points[tri[v]];
+				corners[3 * v][k] = p.x;
+				corners[3 * v + 1][k] = p.y;
+				corners[3 * v + 2][k] = p.z;
+			}
+		}
+		Lane ax = load(corners[0]), ay = load(corners[1]), az = load(corners[2]);
+		Lane bx = load(corners[3]), by = load(corners[4]), bz = load(corners[5]);
+		Lane cx = load(corners[6]), cy = load(corners[7]), cz = load(corners[8]);
+
+		Lane e1x = sub(bx, ax), e1y = sub(by, ay), e1z = sub(bz, az);
+		Lane e2x = sub(cx, ax), e2y = sub(cy, ay), e2z = sub(cz, az);
+		Lane nx = sub(mul(e1y, e2z), mul(e1z, e2y));
+		Lane ny = sub(mul(e1z, e2x), mul(e1x, e2z));
+		Lane nz = sub(mul(e1x, e2y), mul(e1y, e2x));
+
+		// Flip the normals that face the origin
+		Lane sx = add(add(ax, bx), cx);
+		Lane sy = add(add(ay, by), cy);
+		Lane sz = add(add(az, bz), cz);
+		Lane facing = add(add(mul(nx, sx), mul(ny, sy)), mul(nz, sz));
+		Lane flip = bitAnd(lessThan(facing, zero), sign_bit);
+		nx = bitXor(nx, flip);
+		ny = bitXor(ny, flip);
+		nz = bitXor(nz, flip);
+
+		Lane inv_length = divide(one, squareRoot(add(add(mul(nx, nx), mul(ny, ny)), mul(nz, nz))));
+		store(corners[0], mul(nx, inv_length));
+		store(corners[1], mul(ny, inv_length));
+		store(corners[2], mul(nz, inv_length));
+		for (size_t k = 0; k < kLanes; k++)
+			out[i + k] = glm::vec3(corners[0][k], corners[1][k], corners[2][k]);
+	}
+
+	for (size_t i = simd_count; i < count; i++)
+	{
+		const glm::uvec3& tri = triangles[i];
+		out[i] = circumcenter(points[tri[0]], points[tri[1]], points[tri[2]]);
+	}
+}
+
+#else
+
+void circumcenters(const glm::vec3* points, const glm::uvec3* triangles, size_t count, glm::vec3* out)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::uvec3& tri = triangles[i];
+		out[i] = circumcenter(points[tri[0]], points[tri[1]], points[tri[2]]);
+	}
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CIRCUMCENTER_H
+#define CIRCUMCENTER_H
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// The Voronoi vertex of a hull triangle is the circumcenter of the
+// tetrahedron (origin, a, b, c) projected onto the unit sphere. That
+// circumcenter lies on the line through the origin perpendicular to the
+// triangle, so the vertex is just the triangle's outward unit normal.
+glm::vec3 circumcenter(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+// circumcenter() of count triangles, 8 (AVX2) or 4 (SSE2) at a time with a
+// scalar loop for the rest. Gives the same results as the scalar version.
+void circumcenters(const glm::vec3* points, const glm::uvec3* triangles, size_t count, glm::vec3* out);
+
+// Instruction set circumcenters() was compiled for: "AVX2", "SSE2" or "scalar"
+const char* circumcenterInstructionSet();
+
+#endif
@@ -1,17 +1,41 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstddef>
+
+// Region count limits. The interactive renderer is capped lower than the
+// headless generator.
+const unsigned kMinRegions = 500;
+const unsigned kMaxRegions = 100000;
+const unsigned kMaxHeadlessRegions = 2000000;
+
+// Incremental relaxation falls back to rebuilding the convex hull when
+// repairing it takes more than this many edge flips per point
+const float kMaxRelaxFlipsPerPoint = 0.25f;
+
+// Bucketing the hull triangles by point only spreads across threads when each
+// thread gets at least this many triangles
+const int kMinTrisPerThread = 16384;
+
 // Elevation/noise constatns
 const float elevation_divisor = 10.0f;
 const float el_frequency = 1.0f;
 const float el_amplitude = 1.0f;
 const float el_lacunarity = 6.0f;
 const float el_persistence = 1 / el_lacunarity;
+const size_t el_octaves = 24;
+// Octaves whose combined amplitude could change the noise by less than this
+// are skipped: with the persistence above only about the first 9 matter
+const float el_tolerance = 1e-7f;
 
 const float kNear = 0.1f;
 const float kFar = 1000.0f;
 const float kFov = 45.0f;
 
+// Distance of the camera from the planet's center, where the GUI starts it and
+// where rendered images are taken from
+const float kCameraDistance = 5.0f;
+
 const float kFloorXMin = -5.0f;
 const float kFloorXMax = 5.0f;
 const float kFloorZMin = -5.0f;
@@ -0,0 +1,263 @@
+#include "exporter.h"
+#include "biome.h"
+#include "mesh.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Bytes buffered before each write to the file
+const size_t kChunkBytes = 1 << 16;
+
+// Encodes values as little-endian, whatever the host, and writes them out a
+// chunk at a time
+class ChunkWriter {
+public:
+	explicit ChunkWriter(std::ostream& out) : out_(out) {}
+	~ChunkWriter() { flush(); }
+
+	void putByte(uint8_t value)
+	{
+		reserve(1);
+		buffer_[size_++] = value;
+	}
+
+	void putBytes(const char* bytes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			putByte(static_cast<uint8_t>(bytes[i]));
+	}
+
+	void putUint(uint32_t value)
+	{
+		reserve(4);
+		for (int i = 0; i < 4; i++)
+			buffer_[size_++] = static_cast<uint8_t>(value >> (8 * i));
+	}
+
+	void putFloat(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		putUint(bits);
+	}
+
+	void putVec3(const glm::vec3& v)
+	{
+		putFloat(v.x);
+		putFloat(v.y);
+		putFloat(v.z);
+	}
+
+	void flush()
+	{
+		out_.write(reinterpret_cast<const char*>(buffer_), size_);
+		size_ = 0;
+	}
+
+private:
+	void reserve(size_t bytes)
+	{
+		if (size_ + bytes > kChunkBytes)
+			flush();
+	}
+
+	std::ostream& out_;
+	uint8_t buffer_[kChunkBytes];
+	size_t size_ = 0;
+};
+
+uint8_t colorByte(float c)
+{
+	return static_cast<uint8_t>(c * 255.0f + 0.5f);
+}
+
+// planet.frag writes its colors to the framebuffer as they are, i.e. as sRGB,
+// while glTF vertex colors are linear
+float srgbToLinear(float c)
+{
+	return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+void appendVec3(std::ostream& json, const glm::vec3& v)
+{
+	json << "[" << v.x << "," << v.y << "," << v.z << "]";
+}
+
+std::string lowercaseExtension(const std::string& filename)
+{
+	size_t dot = filename.rfind('.');
+	if (dot == std::string::npos || filename.find_first_of("/\\", dot) != std::string::npos)
+		return std::string();
+	std::string extension = filename.substr(dot + 1);
+	for (char& c : extension)
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	return extension;
+}
+
+}
+
+bool writeOBJ(const Mesh& mesh, const std::string& filename)
+{
+	std::ofstream obj(filename);
+	if (!obj)
+		return false;
+
+	obj << "o planet\n";
+	for (const glm::vec3& v : mesh.vertices)
+		obj << "v " << v.x << " " << v.y << " " << v.z << "\n";
+
+	// OBJ indices start at 1
+	for (const glm::uvec3& f : mesh.faces)
+		obj << "f " << f[0] + 1 << " " << f[1] + 1 << " " << f[2] + 1 << "\n";
+
+	return static_cast<bool>(obj);
+}
+
+bool writePLY(const Mesh& mesh, const BiomeParams& biome, const std::string& filename)
+{
+	std::ofstream ply(filename, std::ios::binary);
+	if (!ply)
+		return false;
+
+	ply << "ply\n"
+	    << "format binary_little_endian 1.0\n"
+	    << "element vertex " << mesh.vertices.size() << "\n"
+	    << "property float x\n"
+	    << "property float y\n"
+	    << "property float z\n"
+	    << "property float elevation\n"
+	    << "property uchar red\n"
+	    << "property uchar green\n"
+	    << "property uchar blue\n"
+	    << "element face " << mesh.faces.size() << "\n"
+	    << "property list uchar uint vertex_indices\n"
+	    << "end_header\n";
+
+	{
+		ChunkWriter out(ply);
+		for (const glm::vec3& v : mesh.vertices) {
+			out.putVec3(v);
+			out.putFloat(vertexElevation(v, biome));
+			glm::vec3 color = biomeColor(v, biome);
+			out.putByte(colorByte(color.x));
+			out.putByte(colorByte(color.y));
+			out.putByte(colorByte(color.z));
+		}
+		for (const glm::uvec3& f : mesh.faces) {
+			out.putByte(3);
+			out.putUint(f[0]);
+			out.putUint(f[1]);
+			out.putUint(f[2]);
+		}
+	}
+
+	return static_cast<bool>(ply);
+}
+
+bool writeGLB(const Mesh& mesh, const BiomeParams& biome, const std::string& filename)
+{
+	// The buffer holds the positions, colors, elevations and indices one after
+	// another, all 4 byte aligned as glTF requires
+	const size_t num_vertices = mesh.vertices.size();
+	const size_t num_indices = mesh.faces.size() * 3;
+	const size_t positions_bytes = num_vertices * 12;
+	const size_t colors_bytes = num_vertices * 12;
+	const size_t elevations_bytes = num_vertices * 4;
+	const size_t indices_bytes = num_indices * 4;
+	const size_t buffer_bytes = positions_bytes + colors_bytes + elevations_bytes + indices_bytes;
+	if (buffer_bytes > std::numeric_limits<uint32_t>::max() - 1024)
+		return false;
+
+	// POSITION needs its bounds in the JSON, which comes before the buffer
+	glm::vec3 min_position(0.0f), max_position(0.0f);
+	if (num_vertices > 0) {
+		min_position = max_position = mesh.vertices[0];
+		for (const glm::vec3& v : mesh.vertices) {
+			min_position = glm::min(min_position, v);
+			max_position = glm::max(max_position, v);
+		}
+	}
+
+	std::ostringstream json;
+	json.precision(std::numeric_limits<float>::max_digits10);
+	json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"planets\"},"
+	     << "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+	     << "\"nodes\":[{\"name\":\"planet\",\"mesh\":0}],"
+	     << "\"meshes\":[{\"name\":\"planet\",\"primitives\":[{\"attributes\":{\"POSITION\":0,\"COLOR_0\":1,\"_ELEVATION\":2},\"indices\":3,\"mode\":4}]}],"
+	     << "\"buffers\":[{\"byteLength\":" << buffer_bytes << "}],"
+	     << "\"bufferViews\":["
+	     << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << positions_bytes << ",\"target\":34962},"
+	     << "{\"buffer\":0,\"byteOffset\":" << positions_bytes << ",\"byteLength\":" << colors_bytes << ",\"target\":34962},"
+	     << "{\"buffer\":0,\"byteOffset\":" << positions_bytes + colors_bytes << ",\"byteLength\":" << elevations_bytes << ",\"target\":34962},"
+	     << "{\"buffer\":0,\"byteOffset\":" << positions_bytes + colors_bytes + elevations_bytes << ",\"byteLength\":" << indices_bytes << ",\"target\":34963}],"
+	     << "\"accessors\":["
+	     << "{\"bufferView\":0,\"componentType\":5126,\"count\":" << num_vertices << ",\"type\":\"VEC3\",\"min\":";
+	appendVec3(json, min_position);
+	json << ",\"max\":";
+	appendVec3(json, max_position);
+	json << "},"
+	     << "{\"bufferView\":1,\"componentType\":5126,\"count\":" << num_vertices << ",\"type\":\"VEC3\"},"
+	     << "{\"bufferView\":2,\"componentType\":5126,\"count\":" << num_vertices << ",\"type\":\"SCALAR\"},"
+	     << "{\"bufferView\":3,\"componentType\":5125,\"count\":" << num_indices << ",\"type\":\"SCALAR\"}]}";
+	std::string json_chunk = json.str();
+	// Chunks are padded to 4 bytes, the JSON one with spaces
+	json_chunk.resize((json_chunk.size() + 3) / 4 * 4, ' ');
+
+	std::ofstream glb(filename, std::ios::binary);
+	if (!glb)
+		return false;
+
+	{
+		ChunkWriter out(glb);
+		out.putUint(0x46546C67); // "glTF"
+		out.putUint(2);
+		out.putUint(static_cast<uint32_t>(12 + 8 + json_chunk.size() + 8 + buffer_bytes));
+
+		out.putUint(static_cast<uint32_t>(json_chunk.size()));
+		out.putUint(0x4E4F534A); // "JSON"
+		out.putBytes(json_chunk.data(), json_chunk.size());
+
+		out.putUint(static_cast<uint32_t>(buffer_bytes));
+		out.putUint(0x004E4942); // "BIN"
+		for (const glm::vec3& v : mesh.vertices)
+			out.putVec3(v);
+		for (const glm::vec3& v : mesh.vertices) {
+			glm::vec3 color = biomeColor(v, biome);
+			out.putVec3(glm::vec3(srgbToLinear(color.x), srgbToLinear(color.y), srgbToLinear(color.z)));
+		}
+		for (const glm::vec3& v : mesh.vertices)
+			out.putFloat(vertexElevation(v, biome));
+		for (const glm::uvec3& f : mesh.faces) {
+			out.putUint(f[0]);
+			out.putUint(f[1]);
+			out.putUint(f[2]);
+		}
+	}
+
+	return static_cast<bool>(glb);
+}
+
+bool exportPlanet(const Mesh& mesh, const BiomeParams& biome, const std::string& filename)
+{
+	std::string extension = lowercaseExtension(filename);
+	if (extension == "ply")
+		return writePLY(mesh, biome, filename);
+	if (extension == "glb")
+		return writeGLB(mesh, biome, filename);
+	return writeOBJ(mesh, filename);
+}
+
+std::string suffixedFilename(const std::string& filename, const std::string& suffix)
+{
+	size_t dot = filename.rfind('.');
+	if (dot == std::string::npos || filename.find_first_of("/\\", dot) != std::string::npos)
+		return filename + "_" + suffix;
+	return filename.substr(0, dot) + "_" + suffix + filename.substr(dot);
+}
@@ -0,0 +1,33 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <string>
+
+class Mesh;
+struct BiomeParams;
+
+// The exporters stream the planet's arrays to the file a fixed-size chunk at
+// a time, converting them on the way, so exporting never holds a second copy
+// of the planet in memory.
+
+// Write the planet's vertices and faces as a Wavefront OBJ file
+bool writeOBJ(const Mesh& mesh, const std::string& filename);
+
+// Write the planet as a binary little-endian PLY file. Each vertex has its
+// elevation above the ocean and its biome color as 8 bit red, green and blue.
+bool writePLY(const Mesh& mesh, const BiomeParams& biome, const std::string& filename);
+
+// Write the planet as a binary glTF 2.0 file with a single mesh. Its
+// vertices have a POSITION, a linear COLOR_0 biome color and an _ELEVATION
+// above the ocean.
+bool writeGLB(const Mesh& mesh, const BiomeParams& biome, const std::string& filename);
+
+// Write the planet in the format given by the file name's extension: PLY for
+// .ply, binary glTF for .glb and OBJ otherwise
+bool exportPlanet(const Mesh& mesh, const BiomeParams& biome, const std::string& filename);
+
+// The file name for one output of a batch: the name with "_" and the suffix
+// inserted before its extension, e.g. planet_8675309.obj
+std::string suffixedFilename(const std::string& filename, const std::string& suffix);
+
+#endif
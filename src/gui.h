@@ -6,6 +6,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/io.hpp>
 #include <GLFW/glfw3.h>
+#include "config.h"
 
 struct Mesh;
 
@@ -48,7 +49,7 @@ private:
 	int current_button_ = -1;
 	float roll_speed_ = M_PI / 64.0f;
 	float last_x_ = 0.0f, last_y_ = 0.0f, current_x_ = 0.0f, current_y_ = 0.0f;
-	float camera_distance_ = 5.0f;
+	float camera_distance_ = kCameraDistance;
 	float pan_speed_ = 0.1f;
 	float rotation_speed_ = 0.02f;
 	float zoom_speed_ = 0.1f;
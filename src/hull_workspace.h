@@ -0,0 +1,28 @@
+#ifndef HULL_WORKSPACE_H
+#define HULL_WORKSPACE_H
+
+#include "triangulation.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <QuickHull.hpp>
+
+// Buffers for computing and carrying convex hulls, kept alive across
+// relaxation iterations and across the planets of a batch so they keep their
+// capacity instead of growing from nothing every time
+struct HullWorkspace {
+	// 32 bit indices, the same as the rest of the mesh
+	quickhull::QuickHull<float, uint32_t> quickhull;
+	quickhull::HalfEdgeMesh<float, uint32_t> mesh;
+
+	// HullTriangulation half-edge of each QuickHull half-edge, and the
+	// adjacency built from them
+	std::vector<uint32_t> slots;
+	std::vector<uint32_t> opposite;
+
+	// Hull carried between the relaxation iterations of a planet
+	HullTriangulation topology;
+};
+
+#endif
@@ -1,14 +1,20 @@
 #include <GL/glew.h>
 
+#include "biome.h"
 #include "config.h"
+#include "exporter.h"
 #include "gui.h"
 #include "mesh.h"
+#include "offscreen_target.h"
+#include "planet_cache.h"
+#include "planet_file.h"
 #include "render_pass.h"
 
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -58,7 +64,8 @@ void ErrorCallback(int error, const char* description) {
 	std::cerr << "GLFW Error: " << description << "\n";
 }
 
-GLFWwindow* init_glefw()
+// A hidden window still gives a context to render offscreen with
+GLFWwindow* init_glefw(bool visible)
 {
 	if (!glfwInit())
 		exit(EXIT_FAILURE);
@@ -68,6 +75,7 @@ GLFWwindow* init_glefw()
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_SAMPLES, 4);
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 	auto ret = glfwCreateWindow(window_width, window_height, window_title.data(), nullptr, nullptr);
 	CHECK_SUCCESS(ret != nullptr);
 	glfwMakeContextCurrent(ret);
@@ -107,33 +115,149 @@ glm::vec3 parseHexCode(std::string hexstring)
 	return glm::vec3(r, g, b);
 }
 
+// An array that is drawn, wherever it is stored
+template<typename T>
+struct DrawArray {
+	const T* begin = nullptr;
+	size_t count = 0;
+
+	const T* data() const { return begin; }
+	size_t size() const { return count; }
+};
+
+// Arrays the planet is drawn from, either those of a generated Mesh or the
+// sections of a mapped planet file, so a stored planet goes from the file to
+// the GPU without being copied
+struct PlanetDrawData {
+	DrawArray<glm::vec3> hull_points;
+	DrawArray<glm::uvec2> hull_indices;
+	DrawArray<glm::uvec3> hull_faces;
+	DrawArray<glm::vec3> vertices;
+	DrawArray<glm::uvec2> lines;
+	DrawArray<glm::uvec3> faces;
+};
+
+template<typename T>
+DrawArray<T> drawArray(const std::vector<T>& v)
+{
+	DrawArray<T> array;
+	array.begin = v.data();
+	array.count = v.size();
+	return array;
+}
+
+template<typename T>
+DrawArray<T> drawArray(const PlanetFileView& view, PlanetSection id)
+{
+	DrawArray<T> array;
+	array.begin = view.data<T>(id);
+	array.count = view.size(id);
+	return array;
+}
+
+PlanetDrawData drawData(const Mesh& mesh)
+{
+	PlanetDrawData planet;
+	planet.hull_points = drawArray(mesh.hull_points);
+	planet.hull_indices = drawArray(mesh.hull_indices);
+	planet.hull_faces = drawArray(mesh.hull_faces);
+	planet.vertices = drawArray(mesh.vertices);
+	planet.lines = drawArray(mesh.lines);
+	planet.faces = drawArray(mesh.faces);
+	return planet;
+}
+
+PlanetDrawData drawData(const PlanetFileView& view)
+{
+	PlanetDrawData planet;
+	planet.hull_points = drawArray<glm::vec3>(view, PlanetSection::HullPoints);
+	planet.hull_indices = drawArray<glm::uvec2>(view, PlanetSection::HullIndices);
+	planet.hull_faces = drawArray<glm::uvec3>(view, PlanetSection::HullFaces);
+	planet.vertices = drawArray<glm::vec3>(view, PlanetSection::Vertices);
+	planet.lines = drawArray<glm::uvec2>(view, PlanetSection::Lines);
+	planet.faces = drawArray<glm::uvec3>(view, PlanetSection::Faces);
+	return planet;
+}
+
+// Point planet at the arrays of the planet with the parameters. A planet from
+// the planet file or the cache is drawn straight from the file mapped in view,
+// a planet that has to be generated from its Mesh in generated. A planet file
+// replaces params with those its planet was generated with.
+bool loadPlanet(GenerationParams& params, const std::string& cache_dir, const std::string& planet_file,
+		PlanetFileView& view, Mesh& generated, PlanetDrawData& planet)
+{
+	view.close();
+	generated = Mesh();
+	if (!planet_file.empty()) {
+		if (!view.open(planet_file)) {
+			std::cerr << "Failed to open planet file " << planet_file << "\n";
+			return false;
+		}
+		view.getParams(params);
+	} else if (openCachedPlanet(cache_dir, params, view)) {
+		std::cout << "Loaded planet from " << planetCacheFilename(cache_dir, params) << std::endl;
+	} else {
+		generated = Mesh(params);
+		if (!cache_dir.empty() && !storeCachedPlanet(cache_dir, params, generated))
+			std::cerr << "Failed to store the planet in " << cache_dir << "\n";
+	}
+	planet = view.isOpen() ? drawData(view) : drawData(generated);
+	return true;
+}
+
+// Image file for one frame of a batch, numbered by seed when rendering several
+// planets and by angle when rendering several angles,
+// e.g. planet.jpg -> planet_8675309_2.jpg
+std::string frameFilename(const std::string& render_to, unsigned seed, unsigned count, unsigned angle, unsigned angles)
+{
+	std::string filename = render_to;
+	if (count > 1)
+		filename = suffixedFilename(filename, std::to_string(seed));
+	if (angles > 1)
+		filename = suffixedFilename(filename, std::to_string(angle));
+	return filename;
+}
+
 int main(int argc, char* argv[])
 {
 	// Planet parameters
-	static unsigned num_regions;
+	GenerationParams params;
 	static int height_param;
-	static float ocean_height;
-	static unsigned noise_seed;
 
 	std::string ocean_str, snow_str, coast_str, vegetation_str;
 
-	static glm::vec3 ocean_c;
-	static glm::vec3 snow_c;
-	static glm::vec3 coast_c;
-	static glm::vec3 vegetation_c;
+	// Surface colors, shared by the planet shaders and exports
+	static BiomeParams biome;
 
 	// Draw paramters
 	bool draw_planet = true;
 	bool draw_poly_lines = false;
 	bool draw_hull = false;
 
+	// Headless generation
+	bool headless = false;
+	std::string output;
+	std::string hull_algorithm;
+
+	// Planet cache, and a planet file to show instead of generating a planet
+	std::string cache_dir;
+	std::string planet_file;
+
+	// Offscreen rendering of a batch of images
+	std::string render_to;
+	unsigned count;
+	unsigned angles;
+
 	try {
 		po::options_description desc("Allowed options");
 		desc.add_options()
 			("help,h", "Display help messagee")
-			("regions,r", po::value<unsigned>(&num_regions)->default_value(10000), "Set the number of regions, between 500 and 100,000")
+			("regions,r", po::value<unsigned>(&params.num_regions)->default_value(10000), "Set the number of regions, between 500 and 100,000")
+			("relax", po::value<unsigned>(&params.relax_iterations)->default_value(1), "Set the number of Lloyd relaxation iterations used to space out the regions")
+			("rebuild_hull", "Rebuild the convex hull from scratch on every relaxation iteration instead of repairing the previous one")
+			("hull_algorithm", po::value<std::string>(&hull_algorithm)->default_value("quickhull"), "Algorithm for new convex hulls: quickhull, or delaunay for the faster spherical Delaunay triangulation")
 			("ocean_ht,o", po::value<int>(&height_param)->default_value(120), "Set the height of the ocean, between 0 (everything terrain) and 200 (everything underwater)")
-			("seed,s", po::value<unsigned>(&noise_seed)->default_value(8675309), "Set the seed for the height noise function, between 0 and 4,294,967,295")
+			("seed,s", po::value<unsigned>(&params.noise_seed)->default_value(8675309), "Set the seed for the planet's points and height noise, between 0 and 4,294,967,295")
 			("planet,p", "Don't render the planet. Not setting this flag renders the planet as is default behavior")
 			("polygons,g", "Render the polygons on the terrain of the planet.")
 			("hull,l", "Render the convex hull of the original points. Need to also hide the planet with --planet or -p")
@@ -141,6 +265,16 @@ int main(int argc, char* argv[])
 			("snow_color", po::value<std::string>(&snow_str)->default_value("ffffff"), "Set the color of the snow in hexadecimal\n(000000 - ffffff)")
 			("coast_color", po::value<std::string>(&coast_str)->default_value("edd640"), "Set the color of the coast in hexadecimal\n(000000 - ffffff)")
 			("vegetation_color", po::value<std::string>(&vegetation_str)->default_value("006600"), "Set the color of the vegetation in hexadecimal\n(000000 - ffffff)")
+			("headless", "Generate the planet without opening a window, then exit")
+			("output", po::value<std::string>(&output), "Write the generated planet to this file: PLY with elevations and colors for .ply, binary glTF with the same for .glb, Wavefront OBJ otherwise")
+			("cache_dir", po::value<std::string>(&cache_dir)->default_value(defaultPlanetCacheDir()), "Load planets generated before from this directory, and store new ones in it")
+			("no_cache", "Always generate the planet, without using or updating the cache")
+			("planet_file", po::value<std::string>(&planet_file), "Show the planet in this planet file, e.g. written by planetgen --planet_file, instead of generating one")
+			("render_to", po::value<std::string>(&render_to), "Render the planet to this JPEG file without showing the window, then exit. Several images are numbered by seed and angle")
+			("count", po::value<unsigned>(&count)->default_value(1), "With --render_to, render this many planets with consecutive seeds starting at --seed")
+			("angles", po::value<unsigned>(&angles)->default_value(1), "With --render_to, render each planet from this many angles, evenly spaced around it")
+			("width", po::value<int>(&window_width)->default_value(window_width), "Width of the window, or of the rendered images")
+			("height", po::value<int>(&window_height)->default_value(window_height), "Height of the window, or of the rendered images")
 		;
 
 		po::variables_map vm;
@@ -153,8 +287,29 @@ int main(int argc, char* argv[])
 		}
 
 		// Regions
-		if (num_regions < 500 || num_regions > 100000) {
-			std::cerr << "Invalid number of regions. Must be in range [500-100000]\n";
+		if (params.num_regions < kMinRegions || params.num_regions > kMaxRegions) {
+			std::cerr << "Invalid number of regions. Must be in range [" << kMinRegions << "-" << kMaxRegions << "]\n";
+			return 1;
+		}
+
+		if (vm.count("rebuild_hull")) params.incremental_relax = false;
+
+		// Rendered images
+		if (count < 1 || angles < 1 || window_width < 1 || window_height < 1) {
+			std::cerr << "Invalid number or size of images.\n";
+			return 1;
+		}
+		// A planet file holds a single planet, which --count would render
+		// again and again under the names of seeds never generated
+		if (count > 1 && !planet_file.empty()) {
+			std::cerr << "Can only render one planet from a planet file.\n";
+			return 1;
+		}
+
+		if (hull_algorithm == "delaunay") {
+			params.hull_algorithm = HullAlgorithm::SphereDelaunay;
+		} else if (hull_algorithm != "quickhull") {
+			std::cerr << "Invalid hull algorithm " << hull_algorithm << ".\n";
 			return 1;
 		}
 
@@ -163,7 +318,7 @@ int main(int argc, char* argv[])
 			std::cerr << "Invalid ocean height parameter.\n";
 			return 1;
 		}
-		ocean_height = 1.0f + ((height_param / 1000.0f) - 0.1f);
+		biome.ocean_height = oceanHeight(height_param);
 
 		// Seed, unneeded
 
@@ -171,12 +326,14 @@ int main(int argc, char* argv[])
 		if (vm.count("planet")) draw_planet = false;
 		if (vm.count("polygons")) draw_poly_lines = true;
 		if (vm.count("hull")) draw_hull = true;
+		if (vm.count("headless")) headless = true;
+		if (vm.count("no_cache")) cache_dir.clear();
 
 		// Colors
-		ocean_c = parseHexCode(ocean_str);
-		snow_c = parseHexCode(snow_str);
-		coast_c = parseHexCode(coast_str);
-		vegetation_c = parseHexCode(vegetation_str);
+		biome.ocean_color = parseHexCode(ocean_str);
+		biome.snow_color = parseHexCode(snow_str);
+		biome.coast_color = parseHexCode(coast_str);
+		biome.vegetation_color = parseHexCode(vegetation_str);
 	} catch (std::exception& e) {
 		std::cerr << "error: " << e.what() << "\n";
 		return 1;
@@ -184,15 +341,37 @@ int main(int argc, char* argv[])
 		std::cerr << "Exception of unknown type!\n";
 	}
 
-	GLFWwindow *window = init_glefw();
-	GUI gui(window);
+	// Skip window and context creation entirely when running headless
+	if (headless) {
+		Mesh planet;
+		if (!planet_file.empty()) {
+			uint32_t generator_version;
+			if (!readPlanetFile(planet_file, planet, params, generator_version)) {
+				std::cerr << "Failed to read planet file " << planet_file << "\n";
+				return 1;
+			}
+		} else {
+			planet = cachedPlanet(params, cache_dir);
+		}
+		if (!output.empty() && !exportPlanet(planet, biome, output)) {
+			std::cerr << "Failed to write " << output << "\n";
+			return 1;
+		}
+		return 0;
+	}
+
+	GLFWwindow *window = init_glefw(render_to.empty());
 
 	/** I. Build meshes **/
 	std::vector<glm::vec3> floor_vertices;
 	std::vector<glm::uvec3> floor_faces;
 	create_floor(floor_vertices, floor_faces);
 
-	Mesh planet(num_regions, noise_seed);
+	PlanetFileView planet_view;
+	Mesh generated;
+	PlanetDrawData planet;
+	if (!loadPlanet(params, cache_dir, planet_file, planet_view, generated, planet))
+		return 1;
 
 	/** II. Build Uniforms **/
 	MatrixPointers mats;
@@ -203,14 +382,14 @@ int main(int argc, char* argv[])
 	std::function<glm::mat4()> proj_data = [&mats]() { return *mats.projection; };
 
 	// Elevation data
-	std::function<float()> ocean_lvl = []() { return ocean_height; };
-	std::function<float()> max_el = []() { return (1.0f / elevation_divisor) + (1.0f - ocean_height); };
+	std::function<float()> ocean_lvl = []() { return biome.ocean_height; };
+	std::function<float()> max_el = []() { return biome.maxElevation(); };
 
 	// Color data
-	std::function<glm::vec3()> ocean_color = []() { return ocean_c; };
-	std::function<glm::vec3()> snow_color = []() { return snow_c; };
-	std::function<glm::vec3()> coast_color = []() { return coast_c; };
-	std::function<glm::vec3()> vegetation_color = []() { return vegetation_c; };
+	std::function<glm::vec3()> ocean_color = []() { return biome.ocean_color; };
+	std::function<glm::vec3()> snow_color = []() { return biome.snow_color; };
+	std::function<glm::vec3()> coast_color = []() { return biome.coast_color; };
+	std::function<glm::vec3()> vegetation_color = []() { return biome.vegetation_color; };
 
 	auto std_model = make_uniform("model", model_data);
 	auto std_view = make_uniform("view" , view_data);
@@ -276,10 +455,8 @@ int main(int argc, char* argv[])
 			{ "fragment_color" }
 			);
 
-	while (!glfwWindowShouldClose(window)) {
-		// Setup some basic window stuff.
-		glfwGetFramebufferSize(window, &window_width, &window_height);
-		glViewport(0, 0, window_width, window_height);
+	// Clear, then draw the planet as the draw flags ask, over the floor
+	auto draw_scene = [&]() {
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 		glEnable(GL_DEPTH_TEST);
 		glEnable(GL_MULTISAMPLE);
@@ -290,9 +467,6 @@ int main(int argc, char* argv[])
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glCullFace(GL_BACK);
 
-		gui.updateMatrices();
-		mats = gui.getMatrixPointers();
-
 		if (draw_hull)
 		{
 			// Draw lines
@@ -333,6 +507,79 @@ int main(int argc, char* argv[])
 									  floor_faces.size() * 3,
 									  GL_UNSIGNED_INT,
 									  0));
+	};
+
+	if (!render_to.empty()) {
+		// All the images share the context, shaders and render passes: each
+		// further planet only replaces the passes' buffers
+		bool saved = true;
+		unsigned rendered = 0;
+		auto start = std::chrono::steady_clock::now();
+		{
+			// Scoped so the target deletes its GL objects while the context
+			// is still current
+			OffscreenTarget target;
+			bool ok = target.create(window_width, window_height, 4);
+			if (!ok)
+				std::cerr << "Failed to create the offscreen framebuffer\n";
+
+			// The camera circles the planet at the distance the GUI starts at
+			glm::mat4 model_matrix(1.0f);
+			glm::mat4 view_matrix(1.0f);
+			glm::mat4 projection_matrix = glm::perspective((float)(kFov * (M_PI / 180.0f)),
+					float(window_width) / window_height, kNear, kFar);
+			mats.model = &model_matrix;
+			mats.view = &view_matrix;
+			mats.projection = &projection_matrix;
+
+			for (unsigned i = 0; ok && i < count; i++) {
+				if (i > 0) {
+					params.noise_seed++;
+					if (!loadPlanet(params, cache_dir, planet_file, planet_view, generated, planet)) {
+						ok = false;
+						break;
+					}
+					hull_lines_pass.updateVBO(0, planet.hull_points.data(), planet.hull_points.size());
+					hull_lines_pass.updateIndex(planet.hull_indices.data(), planet.hull_indices.size());
+					hull_pass.updateVBO(0, planet.hull_points.data(), planet.hull_points.size());
+					hull_pass.updateIndex(planet.hull_faces.data(), planet.hull_faces.size());
+					voronoi_lines_pass.updateVBO(0, planet.vertices.data(), planet.vertices.size());
+					voronoi_lines_pass.updateIndex(planet.lines.data(), planet.lines.size());
+					planet_pass.updateVBO(0, planet.vertices.data(), planet.vertices.size());
+					planet_pass.updateIndex(planet.faces.data(), planet.faces.size());
+				}
+
+				for (unsigned angle = 0; angle < angles; angle++) {
+					glm::vec3 eye = glm::rotateY(glm::vec3(0.0f, 0.0f, kCameraDistance),
+							float(2.0 * M_PI * angle / angles));
+					view_matrix = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+					target.bind();
+					draw_scene();
+					saved = target.readFrame(frameFilename(render_to, params.noise_seed, count, angle, angles)) && saved;
+					rendered++;
+				}
+			}
+			// Also after a failure, so the frame read back before it is saved
+			saved = target.finish() && saved && ok;
+		}
+		std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+		std::cout << "Rendered " << rendered << " image(s) in " << total.count() << " s" << std::endl;
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return saved ? 0 : 1;
+	}
+
+	GUI gui(window);
+	while (!glfwWindowShouldClose(window)) {
+		// Setup some basic window stuff.
+		glfwGetFramebufferSize(window, &window_width, &window_height);
+		glViewport(0, 0, window_width, window_height);
+
+		gui.updateMatrices();
+		mats = gui.getMatrixPointers();
+
+		draw_scene();
 
 		// Poll and swap.
 		glfwPollEvents();
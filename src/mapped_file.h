@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A whole file mapped read-only into memory, so it can be read without
+// copying it into a buffer first. The pages are loaded on first access.
+class MappedFile {
+public:
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+
+	// Returns false if the file can't be opened or is empty
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return data_ != nullptr; }
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#endif
+};
+
+#endif
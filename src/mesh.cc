@@ -1,156 +1,265 @@
 #include "mesh.h"
 #include "voronoi.h"
+#include "triangulation.h"
+#include "hull_workspace.h"
 #include "config.h"
 
 #include <iostream>
 #include <algorithm>
+#include <random>
 
-#include <glm/gtc/random.hpp>
-
-Mesh::Mesh(unsigned num_points, unsigned noise_seed)
+Mesh::Mesh(const GenerationParams& params, HullWorkspace* workspace)
 {
-	std::cout << "Generating " << num_points << " vertices." << std::endl;
-	generate_vertices(num_points, 1);
+	// Convex hull carried over between relaxation iterations. The workspace's
+	// still holds the previous planet's hull.
+	HullTriangulation local_topology;
+	HullTriangulation& topology = workspace ? workspace->topology : local_topology;
+	topology.clear();
+	HullTriangulation* reused_topology = params.incremental_relax ? &topology : nullptr;
+
+	std::cout << "Generating " << params.num_regions << " vertices." << std::endl;
+	generate_vertices(params, reused_topology, workspace);
 
 
 	std::cout << "Generating voronoi regions." << std::endl;
 	// Generate num_points random points on the surface of the unit sphere
-	Voronoi voronoi(hull_points);
+	Voronoi voronoi(hull_points, reused_topology, workspace, params.hull_algorithm);
 
 	// Get convex hull indices/faces
 	voronoi.getHullIndices(hull_indices);
-	voronoi.getHullFaces(hull_faces);
+	voronoi.moveHullFaces(hull_faces);
 
-	// Get vertice and groups data from voronoi
-	std::vector<std::vector<size_t>> voronoi_groups;
-	voronoi.getVerticesGroups(vertices, voronoi_groups);
+	// Take over vertice and cell data from voronoi
+	std::vector<uint32_t> cell_neighbors;
+	voronoi.moveVerticesCells(vertices, cell_offsets, cell_vertex_indices);
+	voronoi.moveCellNeighbors(cell_neighbors);
+	voronoi.moveEdges(lines);
 
-	// Make regions from groups, then can populate indices and faces
-	make_regions(voronoi_groups);
+	// Make regions from cells, then can populate indices and faces
+	make_regions();
+	make_adjacency(cell_neighbors);
 
 	std::cout << "Doing elevation simulation." << std::endl;
 	// Do simulations
-	elevation_sim(noise_seed);
+	elevation_sim(params.noise_seed);
 
 	std::cout << "Populating vertex/index vectors." << std::endl;
 	// After simulation, populate indices and faces
 	populate_mesh_data();
 }
 
-void Mesh::generate_vertices(unsigned num_points, int iterations)
+void Mesh::generate_vertices(const GenerationParams& params, HullTriangulation* topology, HullWorkspace* workspace)
 {
+	// The points only depend on the seed, not on global rand() state, so
+	// planets can be generated concurrently and reproduce across runs
+	std::mt19937 rng(params.noise_seed);
+	auto coordinate = [&rng]() { return static_cast<float>(rng()) * (2.0f / 4294967296.0f) - 1.0f; };
+
 	std::vector<glm::vec3> points;
-	for (unsigned i = 0; i < num_points; i++)
+	points.reserve(params.num_regions);
+	for (unsigned i = 0; i < params.num_regions; i++)
 	{
-		// Generate random point on unit sphere
-		glm::vec3 pt(glm::normalize(glm::ballRand(1.0f)));
-		points.push_back(pt);
+		// Generate random point on unit sphere, uniformly by projecting a point
+		// of the unit ball
+		glm::vec3 pt;
+		float length2;
+		do {
+			pt = glm::vec3(coordinate(), coordinate(), coordinate());
+			length2 = glm::dot(pt, pt);
+		} while (length2 > 1.0f || length2 == 0.0f);
+		points.push_back(glm::normalize(pt));
 	}
 
-	for (int i = 0; i < iterations; i++)
+	// Lloyd relaxation: move each point to the center of its Voronoi cell
+	for (unsigned i = 0; i < params.relax_iterations; i++)
 	{
-		Voronoi v(points);
-		std::vector<glm::vec3> new_points = v.getCenters();
-		points.clear();
-		for (auto& p : new_points)
-			points.push_back(glm::normalize(p));
-	}
-	hull_points = points;
-}
+		Voronoi v(points, topology, workspace, params.hull_algorithm);
+		points = v.getCenters(points);
 
-void Mesh::make_regions(std::vector<std::vector<size_t>> groups)
-{
-	for (auto& g : groups)
-		if (g.size() > 0) regions.push_back(new Region(g, &vertices));
+		int num_centers = static_cast<int>(points.size());
+		#pragma omp parallel for
+		for (int j = 0; j < num_centers; j++)
+			points[j] = glm::normalize(points[j]);
+	}
+	hull_points = std::move(points);
 }
 
-void Mesh::elevation_sim(unsigned noise_seed)
+void Mesh::make_regions()
 {
-	// Populate the elevation multiplier for each regions
-	SimplexNoise sn(el_frequency, el_amplitude, el_lacunarity, el_persistence, noise_seed);
-	for (Region *r : regions)
-		r->set_elevation(sn);
+	// Every non-empty cell is a region
+	size_t num_cells = cell_offsets.size() - 1;
+	size_t num_regions = 0;
+	for (size_t i = 0; i < num_cells; i++)
+		if (cell_offsets[i + 1] > cell_offsets[i]) num_regions++;
 
-	std::vector<int> owned_regions(vertices.size(), 0);
-	std::vector<float> multipliers(vertices.size(), 0.0f);
-
-	for (Region *r : regions)
+	regions.resize(num_regions);
+	uint32_t num_voronoi_vertices = static_cast<uint32_t>(vertices.size());
+	size_t region = 0;
+	for (size_t i = 0; i < num_cells; i++)
 	{
-		r->update_affected(owned_regions, multipliers);
+		uint32_t count = cell_offsets[i + 1] - cell_offsets[i];
+		if (count == 0)
+			continue;
+		regions.center_indices[region] = num_voronoi_vertices + static_cast<uint32_t>(region);
+		regions.cell_offsets[region] = cell_offsets[i];
+		regions.cell_counts[region] = count;
+		region++;
 	}
 
-	// Update the elevation of each vertex based on the regions its in
-	for (size_t i = 0; i < vertices.size(); i++)
+	// Calculate the center of each region and add it to the vertices
+	vertices.resize(num_voronoi_vertices + num_regions);
+	int num = static_cast<int>(num_regions);
+	#pragma omp parallel for
+	for (int i = 0; i < num; i++)
 	{
-		vertices[i] = vertices[i] * (multipliers[i] / owned_regions[i]);
+		uint32_t begin = regions.cell_offsets[i];
+		uint32_t end = begin + regions.cell_counts[i];
+		glm::vec3 center(0.0f);
+		for (uint32_t j = begin; j < end; j++)
+			center += vertices[cell_vertex_indices[j]];
+		center /= static_cast<float>(end - begin);
+		vertices[regions.center_indices[i]] = glm::normalize(center);
 	}
 }
 
-void Mesh::populate_mesh_data()
+void Mesh::make_adjacency(const std::vector<uint32_t>& cell_neighbors)
 {
-	for (Region *r : regions)
-		r->addMeshData(lines, faces);
-}
+	// Regions are the non-empty cells in order, so number the cells' points
+	// the same way and give each region the neighbors of its cell. Edges
+	// without a neighbor are left out.
+	size_t num_cells = cell_offsets.size() - 1;
+	std::vector<uint32_t> cell_region(num_cells, 0);
+	uint32_t region = 0;
+	for (size_t i = 0; i < num_cells; i++)
+		if (cell_offsets[i + 1] > cell_offsets[i]) cell_region[i] = region++;
 
-Region::Region(std::vector<size_t> idx_data, std::vector<glm::vec3>* vertices)
-{
-	// Record pointer to vertices
-	this->vertices = vertices;
-	// Copy over indices of this region
-	indices = idx_data;
-	// Calculate center, add it to vertices, and record the index
-	glm::vec3 center(0.0f);
-	for (size_t idx : indices)
+	int num_regions = static_cast<int>(regions.size());
+	region_neighbor_offsets.resize(regions.size() + 1);
+	region_neighbor_offsets[0] = 0;
+	#pragma omp parallel for
+	for (int i = 0; i < num_regions; i++)
 	{
-		center += vertices->at(idx);
+		uint32_t cell_begin = regions.cell_offsets[i];
+		uint32_t count = 0;
+		for (uint32_t j = 0; j < regions.cell_counts[i]; j++)
+			if (cell_neighbors[cell_begin + j] != Voronoi::kNoNeighbor) count++;
+		region_neighbor_offsets[i + 1] = count;
 	}
-	center /= (static_cast<float>(indices.size()));
-	center = glm::normalize(center);
-	center_idx = vertices->size();
-	vertices->push_back(center);
-}
+	for (size_t i = 0; i < regions.size(); i++)
+		region_neighbor_offsets[i + 1] += region_neighbor_offsets[i];
 
-void Region::set_elevation(SimplexNoise sn)
-{
-	glm::vec3 center(vertices->at(center_idx));
-	// Between -1 and 1, so divide by 10 to have +/- 10% variation in elevation
-	elevation_multiplier = 1.0f;
-	float x(center.x);
-	float y(center.y);
-	float z(center.z);
-
-	elevation_multiplier +=  sn.fractal(24, x, y, z) / elevation_divisor;
+	region_neighbors.resize(region_neighbor_offsets.back());
+	#pragma omp parallel for
+	for (int i = 0; i < num_regions; i++)
+	{
+		uint32_t cell_begin = regions.cell_offsets[i];
+		uint32_t next = region_neighbor_offsets[i];
+		for (uint32_t j = 0; j < regions.cell_counts[i]; j++)
+		{
+			uint32_t neighbor = cell_neighbors[cell_begin + j];
+			if (neighbor != Voronoi::kNoNeighbor)
+				region_neighbors[next++] = cell_region[neighbor];
+		}
+	}
 }
-void Region::update_affected(std::vector<int>& owned_regions, std::vector<float>& multipliers)
+
+void Mesh::elevation_sim(unsigned noise_seed)
 {
-	for (size_t idx : indices)
+	// Populate the elevation multiplier for each regions. The noise only reads
+	// its permutation table once constructed, so it can be shared by threads.
+	const SimplexNoise sn(el_frequency, el_amplitude, el_lacunarity, el_persistence, noise_seed, el_tolerance);
+	size_t num_regions = regions.size();
+	std::vector<float> xs(num_regions), ys(num_regions), zs(num_regions);
+	for (size_t i = 0; i < num_regions; i++)
 	{
-		owned_regions[idx]++;
-		multipliers[idx] += elevation_multiplier;
+		const glm::vec3& center = vertices[regions.center_indices[i]];
+		xs[i] = center.x;
+		ys[i] = center.y;
+		zs[i] = center.z;
 	}
-	owned_regions[center_idx]++;
-	multipliers[center_idx] += elevation_multiplier;
-}
 
+	stats.noise_octaves_requested = num_regions * el_octaves;
+	stats.noise_octaves_evaluated = num_regions * sn.effectiveOctaves(el_octaves);
 
-void Region::addMeshData(std::vector<glm::uvec2>& lines, std::vector<glm::uvec3>& faces)
-{
-	// Fill in indices
-	for (size_t i = 0; i < indices.size() - 1; i++)
+	// Noise is computed in SIMD batches, blocks of them in parallel
+	const int block_size = 1024;
+	int num = static_cast<int>(num_regions);
+	int num_blocks = (num + block_size - 1) / block_size;
+	#pragma omp parallel for
+	for (int i = 0; i < num_blocks; i++)
 	{
-		size_t idx1(indices[i]);
-		size_t idx2(indices[i+1]);
-		// Lines
-		lines.push_back(glm::uvec2(idx1, idx2));
+		int begin = i * block_size;
+		int count = std::min(block_size, num - begin);
+		float* multipliers = &regions.elevation_multipliers[begin];
+		sn.fractal(el_octaves, &xs[begin], &ys[begin], &zs[begin], multipliers, count);
 
-		// Triangle
-		faces.push_back(glm::uvec3(center_idx, idx1, idx2));
+		// Between -1 and 1, so divide by 10 to have +/- 10% variation in elevation
+		for (int j = 0; j < count; j++)
+			multipliers[j] = 1.0f + multipliers[j] / elevation_divisor;
 	}
 
-	// Fill in indices at ends
-	size_t first_idx(indices[0]);
-	size_t last_idx(indices[indices.size() - 1]);
+	// Each region affects its center and the vertices of its polygon. List the
+	// regions affecting each vertex in CSR form, in increasing region order so
+	// the sums below add up in the same order as a serial scatter would.
+	std::vector<uint32_t> vertex_offsets(vertices.size() + 1, 0);
+	for (size_t i = 0; i < cell_vertex_indices.size(); i++)
+		vertex_offsets[cell_vertex_indices[i] + 1]++;
+	for (size_t i = 0; i < regions.size(); i++)
+		vertex_offsets[regions.center_indices[i] + 1]++;
+	for (size_t i = 0; i < vertices.size(); i++)
+		vertex_offsets[i + 1] += vertex_offsets[i];
+
+	std::vector<uint32_t> vertex_regions(vertex_offsets.back());
+	std::vector<uint32_t> next(vertex_offsets.begin(), vertex_offsets.end() - 1);
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		uint32_t begin = regions.cell_offsets[i];
+		uint32_t end = begin + regions.cell_counts[i];
+		for (uint32_t j = begin; j < end; j++)
+			vertex_regions[next[cell_vertex_indices[j]]++] = static_cast<uint32_t>(i);
+		vertex_regions[next[regions.center_indices[i]]++] = static_cast<uint32_t>(i);
+	}
 
-	lines.push_back(glm::uvec2(last_idx, first_idx));
-	faces.push_back(glm::uvec3(center_idx, last_idx, first_idx));
-}
\ No newline at end of file
+	// Update the elevation of each vertex based on the regions its in
+	int num_vertices = static_cast<int>(vertices.size());
+	#pragma omp parallel for
+	for (int i = 0; i < num_vertices; i++)
+	{
+		uint32_t begin = vertex_offsets[i];
+		uint32_t end = vertex_offsets[i + 1];
+		float multiplier = 0.0f;
+		for (uint32_t j = begin; j < end; j++)
+			multiplier += regions.elevation_multipliers[vertex_regions[j]];
+		int owned_regions = static_cast<int>(end - begin);
+		vertices[i] = vertices[i] * (multiplier / owned_regions);
+	}
+}
+
+void Mesh::populate_mesh_data()
+{
+	// Every index of a region gives one face, a triangle fan around its
+	// center. Empty cells have no indices, so a region's faces start at its
+	// cell offset. The lines are the Voronoi edges.
+	faces.resize(cell_vertex_indices.size());
+	int num_regions = static_cast<int>(regions.size());
+	#pragma omp parallel for
+	for (int i = 0; i < num_regions; i++)
+	{
+		uint32_t center_idx = regions.center_indices[i];
+		uint32_t begin = regions.cell_offsets[i];
+		uint32_t end = begin + regions.cell_counts[i];
+		for (uint32_t j = begin; j < end; j++)
+		{
+			uint32_t next = j + 1 < end ? j + 1 : begin;
+			faces[j] = glm::uvec3(center_idx, cell_vertex_indices[j], cell_vertex_indices[next]);
+		}
+	}
+}
+
+void RegionTable::resize(size_t num_regions)
+{
+	center_indices.resize(num_regions);
+	cell_offsets.resize(num_regions);
+	cell_counts.resize(num_regions);
+	elevation_multipliers.resize(num_regions);
+}
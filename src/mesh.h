@@ -1,6 +1,7 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <cstdint>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -8,29 +9,61 @@
 
 #include <SimplexNoise.h>
 
-class Region {
-public:
-	Region(std::vector<size_t> idx_data, std::vector<glm::vec3>* vertices);
+#include "voronoi.h"
 
-	// Simulations
-	void set_elevation(SimplexNoise sn);
-	void update_affected(std::vector<int>& owned_regions, std::vector<float>& multipliers);
+// Per-region data as parallel arrays, one entry per non-empty Voronoi cell
+struct RegionTable {
+	// Index of the region's center in Mesh::vertices
+	std::vector<uint32_t> center_indices;
+	// The region's polygon is Mesh::cell_vertex_indices[cell_offsets[i]] onwards,
+	// cell_counts[i] vertices long
+	std::vector<uint32_t> cell_offsets;
+	std::vector<uint32_t> cell_counts;
+	std::vector<float> elevation_multipliers;
 
-	// Populating mesh data
-	void addMeshData(std::vector<glm::uvec2>& lines, std::vector<glm::uvec3>& faces);
+	size_t size() const { return center_indices.size(); }
+	void resize(size_t num_regions);
+};
 
-private:
-	std::vector<glm::vec3>* vertices;
-	std::vector<size_t> indices;
-	size_t center_idx;
+class HullTriangulation;
+struct HullWorkspace;
+
+// Bump whenever a change makes Mesh generate a different planet from the same
+// parameters, so planets stored by an older generator are made again
+const uint32_t kPlanetGeneratorVersion = 2;
+
+// Parameters of planet generation
+struct GenerationParams {
+	unsigned num_regions = 10000;
+	// Seeds both the random points and the height noise
+	unsigned noise_seed = 8675309;
+	unsigned relax_iterations = 1;
+	// Repair the previous relaxation iteration's convex hull with edge flips
+	// instead of computing a new one
+	bool incremental_relax = true;
+	// How hulls that aren't repaired are computed
+	HullAlgorithm hull_algorithm = HullAlgorithm::QuickHull;
+};
 
-	float elevation_multiplier;
+// Work done generating a planet, for profiling
+struct GenerationStats {
+	// Noise octaves asked for over all regions, and the ones evaluated after
+	// skipping those below the noise tolerance
+	size_t noise_octaves_requested = 0;
+	size_t noise_octaves_evaluated = 0;
 };
 
 class Mesh {
 public:
 
-	Mesh(unsigned num_points, unsigned noise_seed);
+	// Planets generated one after another can share a workspace, so the hull
+	// computations reuse its buffers
+	Mesh(const GenerationParams& params, HullWorkspace* workspace = nullptr);
+
+	// Empty planet, e.g. to be filled from a planet file
+	Mesh() {}
+
+	GenerationStats stats;
 
 	// Generator points and convex hull data
 	std::vector<glm::vec3> hull_points;
@@ -42,12 +75,32 @@ public:
 	std::vector<glm::uvec2> lines;
 	std::vector<glm::uvec3> faces;
 
+	RegionTable regions;
+
+	// Vertices of the regions' polygons, as indices into vertices, each polygon
+	// counter-clockwise seen from outside the sphere. RegionTable's cell_offsets
+	// and cell_counts index into this.
+	std::vector<uint32_t> cell_vertex_indices;
+
+	// Region adjacency in CSR form, in the same order as the regions: the
+	// neighbors of region i are region_neighbors[region_neighbor_offsets[i]]
+	// to region_neighbors[region_neighbor_offsets[i + 1] - 1], counter-clockwise
+	// around it seen from outside the sphere. A region is never its own neighbor.
+	std::vector<uint32_t> region_neighbor_offsets;
+	std::vector<uint32_t> region_neighbors;
+
+	size_t num_regions() const { return regions.size(); }
+
 private:
-	std::vector<Region *> regions;
+	// Offsets of the Voronoi cells in cell_vertex_indices, including empty
+	// ones: the polygon of cell i is cell_vertex_indices[cell_offsets[i]] to
+	// cell_vertex_indices[cell_offsets[i + 1] - 1]
+	std::vector<uint32_t> cell_offsets;
 
 	// Initialization functions
-	void generate_vertices(unsigned num_points, int iterations);
-	void make_regions(std::vector<std::vector<size_t>> groups);
+	void generate_vertices(const GenerationParams& params, HullTriangulation* topology, HullWorkspace* workspace);
+	void make_regions();
+	void make_adjacency(const std::vector<uint32_t>& cell_neighbors);
 
 	// Simulation functions
 	void elevation_sim(unsigned noise_seed);
@@ -0,0 +1,125 @@
+#include <GL/glew.h>
+#include "offscreen_target.h"
+
+#include <debuggl.h>
+#include <jpegio.h>
+
+#include <iostream>
+
+OffscreenTarget::~OffscreenTarget()
+{
+	if (framebuffer_)
+		glDeleteFramebuffers(1, &framebuffer_);
+	if (resolve_framebuffer_)
+		glDeleteFramebuffers(1, &resolve_framebuffer_);
+	unsigned renderbuffers[] = { color_, depth_, resolve_color_ };
+	for (unsigned renderbuffer : renderbuffers)
+		if (renderbuffer)
+			glDeleteRenderbuffers(1, &renderbuffer);
+	if (pixel_buffers_[0])
+		glDeleteBuffers(2, pixel_buffers_);
+}
+
+bool OffscreenTarget::create(int width, int height, int samples)
+{
+	width_ = width;
+	height_ = height;
+
+	GLint max_samples = 0;
+	CHECK_GL_ERROR(glGetIntegerv(GL_MAX_SAMPLES, &max_samples));
+	if (samples > max_samples)
+		samples = max_samples;
+	multisampled_ = samples > 1;
+
+	CHECK_GL_ERROR(glGenFramebuffers(1, &framebuffer_));
+	CHECK_GL_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_));
+	CHECK_GL_ERROR(glGenRenderbuffers(1, &color_));
+	CHECK_GL_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, color_));
+	CHECK_GL_ERROR(glRenderbufferStorageMultisample(GL_RENDERBUFFER, multisampled_ ? samples : 0, GL_RGBA8, width, height));
+	CHECK_GL_ERROR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_));
+	CHECK_GL_ERROR(glGenRenderbuffers(1, &depth_));
+	CHECK_GL_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, depth_));
+	CHECK_GL_ERROR(glRenderbufferStorageMultisample(GL_RENDERBUFFER, multisampled_ ? samples : 0, GL_DEPTH_COMPONENT24, width, height));
+	CHECK_GL_ERROR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_));
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	if (complete && multisampled_) {
+		CHECK_GL_ERROR(glGenFramebuffers(1, &resolve_framebuffer_));
+		CHECK_GL_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, resolve_framebuffer_));
+		CHECK_GL_ERROR(glGenRenderbuffers(1, &resolve_color_));
+		CHECK_GL_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, resolve_color_));
+		CHECK_GL_ERROR(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+		CHECK_GL_ERROR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolve_color_));
+		complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+	CHECK_GL_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+	CHECK_GL_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	if (!complete)
+		return false;
+
+	// Rows of RGB pixels, tightly packed as SaveJPEG expects them
+	CHECK_GL_ERROR(glGenBuffers(2, pixel_buffers_));
+	for (unsigned pixel_buffer : pixel_buffers_) {
+		CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer));
+		CHECK_GL_ERROR(glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 3, nullptr, GL_STREAM_READ));
+	}
+	CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	return true;
+}
+
+void OffscreenTarget::bind()
+{
+	CHECK_GL_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_));
+	CHECK_GL_ERROR(glViewport(0, 0, width_, height_));
+}
+
+bool OffscreenTarget::readFrame(const std::string& filename)
+{
+	if (multisampled_) {
+		CHECK_GL_ERROR(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_));
+		CHECK_GL_ERROR(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_framebuffer_));
+		CHECK_GL_ERROR(glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+		CHECK_GL_ERROR(glBindFramebuffer(GL_READ_FRAMEBUFFER, resolve_framebuffer_));
+	} else {
+		CHECK_GL_ERROR(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_));
+	}
+
+	// With a pixel pack buffer bound, glReadPixels returns without waiting for
+	// the frame to finish rendering
+	CHECK_GL_ERROR(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[next_buffer_]));
+	CHECK_GL_ERROR(glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, nullptr));
+	CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	CHECK_GL_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	bool saved = savePending();
+	pending_ = true;
+	pending_filename_ = filename;
+	next_buffer_ = 1 - next_buffer_;
+	return saved;
+}
+
+bool OffscreenTarget::finish()
+{
+	return savePending();
+}
+
+bool OffscreenTarget::savePending()
+{
+	if (!pending_)
+		return true;
+	pending_ = false;
+
+	// The pending frame is in the buffer the next frame isn't read into.
+	// SaveJPEG reads the rows bottom up, the order glReadPixels wrote them in.
+	CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[1 - next_buffer_]));
+	const void* pixels = nullptr;
+	CHECK_GL_ERROR(pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(width_) * height_ * 3, GL_MAP_READ_BIT));
+	bool saved = pixels && SaveJPEG(pending_filename_, width_, height_, static_cast<const unsigned char*>(pixels));
+	if (pixels)
+		CHECK_GL_ERROR(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	CHECK_GL_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	if (!saved)
+		std::cerr << "Failed to save " << pending_filename_ << "\n";
+	return saved;
+}
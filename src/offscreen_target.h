@@ -0,0 +1,57 @@
+#ifndef OFFSCREEN_TARGET_H
+#define OFFSCREEN_TARGET_H
+
+#include <string>
+
+// A framebuffer object frames are rendered into instead of the window, for
+// rendering images without showing anything. Only needs OpenGL 3.3, so it
+// also works on Mesa's software rasterizer.
+//
+// Frames are read back through two pixel buffer objects in turn: readFrame()
+// only starts copying the frame into one of them, and the frame is written to
+// its JPEG file once the next frame has been rendered and is being copied into
+// the other. Rendering a frame thus overlaps reading back the previous one.
+class OffscreenTarget {
+public:
+	OffscreenTarget() {}
+	OffscreenTarget(const OffscreenTarget&) = delete;
+	OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+	~OffscreenTarget();
+
+	// Create the framebuffer and pixel buffers. With more than one sample the
+	// frames are multisampled, and resolved before they are read back.
+	// Returns false if the framebuffer is incomplete.
+	bool create(int width, int height, int samples);
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+	// Draw into the target, over all of it
+	void bind();
+
+	// Start reading back the frame drawn since bind(), to be saved as a JPEG
+	// file, and save the frame read before it. Returns false if saving that
+	// frame failed.
+	bool readFrame(const std::string& filename);
+
+	// Save the last frame read back. Returns false if saving it failed.
+	bool finish();
+
+private:
+	bool savePending();
+
+	int width_ = 0, height_ = 0;
+	bool multisampled_ = false;
+	unsigned framebuffer_ = 0, color_ = 0, depth_ = 0;
+	// Single-sampled framebuffer multisampled frames are resolved into
+	unsigned resolve_framebuffer_ = 0, resolve_color_ = 0;
+
+	unsigned pixel_buffers_[2] = {};
+	// Pixel buffer the next frame is read into. The other one holds the
+	// pending frame, if any.
+	int next_buffer_ = 0;
+	bool pending_ = false;
+	std::string pending_filename_;
+};
+
+#endif
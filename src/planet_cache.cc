@@ -0,0 +1,185 @@
+#include "planet_cache.h"
+#include "planet_file.h"
+#include "mesh.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+const char kPathSeparator = '\\';
+#else
+const char kPathSeparator = '/';
+#endif
+
+bool isSeparator(char c)
+{
+#ifdef _WIN32
+	return c == '\\' || c == '/';
+#else
+	return c == '/';
+#endif
+}
+
+bool makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+	int result = _mkdir(path.c_str());
+#else
+	int result = mkdir(path.c_str(), 0755);
+#endif
+	return result == 0 || errno == EEXIST;
+}
+
+// mkdir -p
+bool makeDirectories(const std::string& path)
+{
+	for (size_t i = 1; i < path.size(); i++)
+		if (isSeparator(path[i]) && !isSeparator(path[i - 1]) && !makeDirectory(path.substr(0, i)))
+			return false;
+	return makeDirectory(path);
+}
+
+std::string joinPath(const std::string& dir, const std::string& name)
+{
+	if (dir.empty() || isSeparator(dir.back()))
+		return dir + name;
+	return dir + kPathSeparator + name;
+}
+
+const uint64_t kFNVOffsetBasis = 14695981039346656037ull;
+const uint64_t kFNVPrime = 1099511628211ull;
+
+// Hashes the value's bytes least significant first, the same on every host
+void hashValue(uint64_t& hash, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		hash ^= (value >> (8 * i)) & 0xFF;
+		hash *= kFNVPrime;
+	}
+}
+
+bool sameParams(const GenerationParams& a, const GenerationParams& b)
+{
+	return a.num_regions == b.num_regions && a.noise_seed == b.noise_seed &&
+	       a.relax_iterations == b.relax_iterations && a.incremental_relax == b.incremental_relax &&
+	       a.hull_algorithm == b.hull_algorithm;
+}
+
+}
+
+std::string defaultPlanetCacheDir()
+{
+#ifdef _WIN32
+	if (const char* local_app_data = std::getenv("LOCALAPPDATA"))
+		return joinPath(local_app_data, "planets");
+#else
+	const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+	if (xdg_cache_home && *xdg_cache_home)
+		return joinPath(xdg_cache_home, "planets");
+	const char* home = std::getenv("HOME");
+	if (home && *home)
+		return joinPath(joinPath(home, ".cache"), "planets");
+#endif
+	return std::string();
+}
+
+uint64_t planetCacheKey(const GenerationParams& params)
+{
+	uint64_t hash = kFNVOffsetBasis;
+	hashValue(hash, kPlanetGeneratorVersion);
+	hashValue(hash, params.num_regions);
+	hashValue(hash, params.noise_seed);
+	hashValue(hash, params.relax_iterations);
+	hashValue(hash, params.incremental_relax ? 1 : 0);
+	hashValue(hash, static_cast<uint32_t>(params.hull_algorithm));
+	return hash;
+}
+
+std::string planetCacheFilename(const std::string& cache_dir, const GenerationParams& params)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.planet", static_cast<unsigned long long>(planetCacheKey(params)));
+	return joinPath(cache_dir, name);
+}
+
+bool openCachedPlanet(const std::string& cache_dir, const GenerationParams& params, PlanetFileView& view)
+{
+	if (cache_dir.empty() || !view.open(planetCacheFilename(cache_dir, params)))
+		return false;
+
+	// Two parameter sets can hash the same, so the stored ones must match too
+	GenerationParams stored;
+	view.getParams(stored);
+	if (view.header().generator_version != kPlanetGeneratorVersion || !sameParams(stored, params)) {
+		view.close();
+		return false;
+	}
+	return true;
+}
+
+bool loadCachedPlanet(const std::string& cache_dir, const GenerationParams& params, Mesh& mesh)
+{
+	PlanetFileView view;
+	if (!openCachedPlanet(cache_dir, params, view))
+		return false;
+	view.copyTo(mesh);
+	return true;
+}
+
+bool storeCachedPlanet(const std::string& cache_dir, const GenerationParams& params, const Mesh& mesh)
+{
+	if (cache_dir.empty() || !makeDirectories(cache_dir))
+		return false;
+
+	std::string filename = planetCacheFilename(cache_dir, params);
+#ifdef _WIN32
+	std::string temporary = filename + "." + std::to_string(_getpid()) + ".tmp";
+#else
+	std::string temporary = filename + "." + std::to_string(getpid()) + ".tmp";
+#endif
+	if (!writePlanetFile(mesh, params, temporary)) {
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+	// POSIX rename replaces an existing file atomically, so if it fails the
+	// cached planet is left alone. Windows doesn't replace an existing file,
+	// so it is removed first.
+	if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+#ifdef _WIN32
+		std::remove(filename.c_str());
+		if (std::rename(temporary.c_str(), filename.c_str()) == 0)
+			return true;
+#endif
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+Mesh cachedPlanet(const GenerationParams& params, const std::string& cache_dir, HullWorkspace* workspace)
+{
+	Mesh planet;
+	if (loadCachedPlanet(cache_dir, params, planet)) {
+		std::cout << "Loaded planet from " << planetCacheFilename(cache_dir, params) << std::endl;
+		return planet;
+	}
+
+	planet = Mesh(params, workspace);
+	if (!cache_dir.empty() && !storeCachedPlanet(cache_dir, params, planet))
+		std::cerr << "Failed to store the planet in " << cache_dir << "\n";
+	return planet;
+}
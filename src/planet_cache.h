@@ -0,0 +1,42 @@
+#ifndef PLANET_CACHE_H
+#define PLANET_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+class Mesh;
+class PlanetFileView;
+struct GenerationParams;
+struct HullWorkspace;
+
+// Generated planets kept on disk as planet files, named after a hash of their
+// generation parameters, so reopening a planet loads it instead of generating
+// it again. A planet made by another version of the generator is a miss.
+
+// $XDG_CACHE_HOME/planets, ~/.cache/planets or %LOCALAPPDATA%\planets on
+// Windows. Empty if none of these can be found.
+std::string defaultPlanetCacheDir();
+
+// 64 bit FNV-1a hash of the parameters and kPlanetGeneratorVersion
+uint64_t planetCacheKey(const GenerationParams& params);
+
+// File the planet generated with params is cached in
+std::string planetCacheFilename(const std::string& cache_dir, const GenerationParams& params);
+
+// Map the planet generated with params if the cache has it, without copying it
+bool openCachedPlanet(const std::string& cache_dir, const GenerationParams& params, PlanetFileView& view);
+
+// Load the planet generated with params if the cache has it
+bool loadCachedPlanet(const std::string& cache_dir, const GenerationParams& params, Mesh& mesh);
+
+// Store the planet generated with params, creating the directory if needed.
+// It is written to a temporary file that is then renamed, so other processes
+// never load a partly written planet.
+bool storeCachedPlanet(const std::string& cache_dir, const GenerationParams& params, const Mesh& mesh);
+
+// The planet generated with params, loaded from the cache if it has it.
+// Otherwise it is generated, with the workspace if given, and stored in the
+// cache. An empty cache_dir always generates the planet.
+Mesh cachedPlanet(const GenerationParams& params, const std::string& cache_dir, HullWorkspace* workspace = nullptr);
+
+#endif
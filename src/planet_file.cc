@@ -0,0 +1,209 @@
+#include "planet_file.h"
+#include "mesh.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::uvec2) == 8 && sizeof(glm::uvec3) == 12,
+              "planet files store glm vectors as packed 32 bit components");
+static_assert(sizeof(PlanetFileHeader) == 40 && sizeof(PlanetFileSection) == 24,
+              "planet file structs must not be padded");
+
+namespace {
+
+// The arrays are written and read as they are in memory
+bool hostIsLittleEndian()
+{
+	const uint32_t one = 1;
+	uint8_t first;
+	std::memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+size_t alignOffset(size_t offset)
+{
+	return (offset + kPlanetFileAlignment - 1) / kPlanetFileAlignment * kPlanetFileAlignment;
+}
+
+// Where a section's data is in memory when writing
+struct SectionData {
+	const void* data;
+	uint32_t element_size;
+	size_t count;
+};
+
+template<typename T>
+SectionData sectionData(const std::vector<T>& v)
+{
+	return SectionData{ v.data(), static_cast<uint32_t>(sizeof(T)), v.size() };
+}
+
+// Size of the elements Mesh stores each section in, in PlanetSection order
+const uint32_t kSectionElementSizes[] = {
+	sizeof(glm::vec3),
+	sizeof(glm::uvec2),
+	sizeof(glm::uvec3),
+	sizeof(glm::vec3),
+	sizeof(glm::uvec2),
+	sizeof(glm::uvec3),
+	sizeof(uint32_t),
+	sizeof(uint32_t),
+	sizeof(uint32_t),
+	sizeof(float),
+	sizeof(uint32_t),
+	sizeof(uint32_t),
+	sizeof(uint32_t),
+};
+static_assert(sizeof(kSectionElementSizes) / sizeof(kSectionElementSizes[0]) == static_cast<size_t>(PlanetSection::Count),
+              "missing planet section");
+
+template<typename T>
+void copySection(const PlanetFileView& view, PlanetSection id, std::vector<T>& v)
+{
+	const T* begin = view.data<T>(id);
+	v.assign(begin, begin + view.size(id));
+}
+
+}
+
+bool writePlanetFile(const Mesh& mesh, const GenerationParams& params, const std::string& filename)
+{
+	if (!hostIsLittleEndian())
+		return false;
+
+	// In PlanetSection order
+	const SectionData sections[] = {
+		sectionData(mesh.hull_points),
+		sectionData(mesh.hull_indices),
+		sectionData(mesh.hull_faces),
+		sectionData(mesh.vertices),
+		sectionData(mesh.lines),
+		sectionData(mesh.faces),
+		sectionData(mesh.regions.center_indices),
+		sectionData(mesh.regions.cell_offsets),
+		sectionData(mesh.regions.cell_counts),
+		sectionData(mesh.regions.elevation_multipliers),
+		sectionData(mesh.region_neighbor_offsets),
+		sectionData(mesh.region_neighbors),
+		sectionData(mesh.cell_vertex_indices),
+	};
+	const uint32_t num_sections = static_cast<uint32_t>(PlanetSection::Count);
+	static_assert(sizeof(sections) / sizeof(sections[0]) == static_cast<size_t>(PlanetSection::Count), "missing planet section");
+
+	PlanetFileHeader header;
+	std::memcpy(header.magic, kPlanetFileMagic, sizeof(header.magic));
+	header.version = kPlanetFileVersion;
+	header.num_sections = num_sections;
+	header.generator_version = kPlanetGeneratorVersion;
+	header.num_regions = params.num_regions;
+	header.noise_seed = params.noise_seed;
+	header.relax_iterations = params.relax_iterations;
+	header.incremental_relax = params.incremental_relax ? 1 : 0;
+	header.hull_algorithm = static_cast<uint32_t>(params.hull_algorithm);
+
+	PlanetFileSection table[num_sections];
+	size_t offset = alignOffset(sizeof(header) + sizeof(table));
+	for (uint32_t i = 0; i < num_sections; i++) {
+		table[i].id = i;
+		table[i].element_size = sections[i].element_size;
+		table[i].offset = offset;
+		table[i].count = sections[i].count;
+		offset = alignOffset(offset + sections[i].element_size * sections[i].count);
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+		return false;
+
+	const char padding[kPlanetFileAlignment] = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(table), sizeof(table));
+	size_t written = sizeof(header) + sizeof(table);
+	for (uint32_t i = 0; i < num_sections; i++) {
+		file.write(padding, table[i].offset - written);
+		size_t bytes = sections[i].element_size * sections[i].count;
+		file.write(static_cast<const char*>(sections[i].data), bytes);
+		written = table[i].offset + bytes;
+	}
+	file.write(padding, offset - written);
+
+	return static_cast<bool>(file);
+}
+
+bool PlanetFileView::open(const std::string& filename)
+{
+	close();
+	if (!hostIsLittleEndian() || !file_.open(filename))
+		return false;
+
+	const uint32_t num_sections = static_cast<uint32_t>(PlanetSection::Count);
+	if (file_.size() < sizeof(PlanetFileHeader) + num_sections * sizeof(PlanetFileSection)) {
+		close();
+		return false;
+	}
+
+	std::memcpy(&header_, file_.data(), sizeof(header_));
+	if (std::memcmp(header_.magic, kPlanetFileMagic, sizeof(header_.magic)) != 0 ||
+	    header_.version != kPlanetFileVersion || header_.num_sections != num_sections) {
+		close();
+		return false;
+	}
+
+	// Every section must be in the file, in order, aligned and hold elements
+	// of the type Mesh has for it
+	sections_ = reinterpret_cast<const PlanetFileSection*>(file_.data() + sizeof(header_));
+	for (uint32_t i = 0; i < num_sections; i++) {
+		const PlanetFileSection& section = sections_[i];
+		if (section.id != i || section.element_size != kSectionElementSizes[i] || section.offset % kPlanetFileAlignment != 0 ||
+		    section.offset > file_.size() || section.count > (file_.size() - section.offset) / section.element_size) {
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void PlanetFileView::close()
+{
+	file_.close();
+	sections_ = nullptr;
+}
+
+void PlanetFileView::getParams(GenerationParams& params) const
+{
+	params.num_regions = header_.num_regions;
+	params.noise_seed = header_.noise_seed;
+	params.relax_iterations = header_.relax_iterations;
+	params.incremental_relax = header_.incremental_relax != 0;
+	params.hull_algorithm = static_cast<HullAlgorithm>(header_.hull_algorithm);
+}
+
+void PlanetFileView::copyTo(Mesh& mesh) const
+{
+	copySection(*this, PlanetSection::HullPoints, mesh.hull_points);
+	copySection(*this, PlanetSection::HullIndices, mesh.hull_indices);
+	copySection(*this, PlanetSection::HullFaces, mesh.hull_faces);
+	copySection(*this, PlanetSection::Vertices, mesh.vertices);
+	copySection(*this, PlanetSection::Lines, mesh.lines);
+	copySection(*this, PlanetSection::Faces, mesh.faces);
+	copySection(*this, PlanetSection::RegionCenterIndices, mesh.regions.center_indices);
+	copySection(*this, PlanetSection::RegionCellOffsets, mesh.regions.cell_offsets);
+	copySection(*this, PlanetSection::RegionCellCounts, mesh.regions.cell_counts);
+	copySection(*this, PlanetSection::RegionElevationMultipliers, mesh.regions.elevation_multipliers);
+	copySection(*this, PlanetSection::RegionNeighborOffsets, mesh.region_neighbor_offsets);
+	copySection(*this, PlanetSection::RegionNeighbors, mesh.region_neighbors);
+	copySection(*this, PlanetSection::CellVertexIndices, mesh.cell_vertex_indices);
+	mesh.stats = GenerationStats();
+}
+
+bool readPlanetFile(const std::string& filename, Mesh& mesh, GenerationParams& params, uint32_t& generator_version)
+{
+	PlanetFileView view;
+	if (!view.open(filename))
+		return false;
+	view.copyTo(mesh);
+	view.getParams(params);
+	generator_version = view.header().generator_version;
+	return true;
+}
@@ -0,0 +1,101 @@
+#ifndef PLANET_FILE_H
+#define PLANET_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.h"
+
+class Mesh;
+struct GenerationParams;
+
+// Binary planet file holding the arrays of a generated Mesh, so a planet can
+// be loaded instead of generated again. All values are little-endian. The
+// file is a PlanetFileHeader, then a PlanetFileSection for each section, then
+// the sections' data, each starting at a multiple of kPlanetFileAlignment.
+const char kPlanetFileMagic[8] = { 'P', 'L', 'A', 'N', 'E', 'T', 'S', '\0' };
+const uint32_t kPlanetFileVersion = 2;
+const size_t kPlanetFileAlignment = 64;
+
+// Mesh array stored in each section
+enum class PlanetSection : uint32_t {
+	HullPoints,
+	HullIndices,
+	HullFaces,
+	Vertices,
+	Lines,
+	Faces,
+	RegionCenterIndices,
+	RegionCellOffsets,
+	RegionCellCounts,
+	RegionElevationMultipliers,
+	RegionNeighborOffsets,
+	RegionNeighbors,
+	CellVertexIndices,
+	Count
+};
+
+struct PlanetFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t num_sections;
+	// kPlanetGeneratorVersion and the GenerationParams the planet was made with
+	uint32_t generator_version;
+	uint32_t num_regions;
+	uint32_t noise_seed;
+	uint32_t relax_iterations;
+	uint32_t incremental_relax;
+	uint32_t hull_algorithm;
+};
+
+struct PlanetFileSection {
+	uint32_t id;
+	// Size of one element, e.g. 12 for a glm::vec3
+	uint32_t element_size;
+	// Byte offset of the data from the start of the file, and number of elements
+	uint64_t offset;
+	uint64_t count;
+};
+
+// A planet file mapped read-only, with pointers straight into its sections.
+// Nothing is parsed or copied: the sections are laid out as the arrays are in
+// memory, so the pointers can be handed to RenderDataInput and uploaded to the
+// GPU from the mapping. They are valid until the view is closed.
+class PlanetFileView {
+public:
+	// Returns false if the file is missing, truncated or not a planet file of
+	// this version
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return file_.isOpen(); }
+	const PlanetFileHeader& header() const { return header_; }
+
+	// The parameters the planet was generated with
+	void getParams(GenerationParams& params) const;
+
+	// Elements in a section, and a pointer to them. The element type must be
+	// the one Mesh stores the section's array in.
+	size_t size(PlanetSection id) const { return static_cast<size_t>(sections_[static_cast<uint32_t>(id)].count); }
+	template<typename T>
+	const T* data(PlanetSection id) const { return reinterpret_cast<const T*>(file_.data() + sections_[static_cast<uint32_t>(id)].offset); }
+
+	// Copy the sections into mesh's arrays
+	void copyTo(Mesh& mesh) const;
+
+private:
+	MappedFile file_;
+	PlanetFileHeader header_;
+	const PlanetFileSection* sections_ = nullptr;
+};
+
+// Write the planet generated with params to a planet file
+bool writePlanetFile(const Mesh& mesh, const GenerationParams& params, const std::string& filename);
+
+// Map a planet file and copy its arrays into mesh. The parameters it was
+// generated with are stored in params and its generator version in
+// generator_version. Returns false if PlanetFileView can't open it.
+bool readPlanetFile(const std::string& filename, Mesh& mesh, GenerationParams& params, uint32_t& generator_version);
+
+#endif
@@ -0,0 +1,534 @@
+#include "voronoi.h"
+#include "allocation_stats.h"
+#include "circumcenter.h"
+#include "hull_workspace.h"
+#include "mesh.h"
+#include "planet_cache.h"
+#include "planet_file.h"
+#include "triangulation.h"
+#include "config.h"
+
+#include <SimplexNoise.h>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/random.hpp>
+
+// Micro-benchmarks for the planet generation stages, run on the same point
+// sets the generator uses: random points on the unit sphere, relaxed.
+
+// The comparator sort that ordered Voronoi cells before they were sorted by
+// angle keys, kept as the baseline. Assumes center is inside the unit sphere
+// (i.e. not on the surface of it).
+struct polyVec {
+
+	polyVec(glm::vec3 pt, glm::vec3 cen, glm::vec3 tp, size_t index) : point(pt), center(cen), top(tp), idx(index) {}
+
+	glm::vec3 point;
+	glm::vec3 center;
+	glm::vec3 top;
+	size_t idx;
+
+	bool CCW;
+	float dot;
+
+	// Sort vertices in order either clockwise or counter-clockwise
+	static bool compare(polyVec v1, polyVec v2) {
+
+		// It's the first vertex, it should stay first
+		if (v1.point == v1.top) {
+			return true;
+		} else if (v2.point == v2.top) {
+			return false;
+		}
+
+		v1.setCCW_dot();
+		v2.setCCW_dot();
+		// If both rotating CCW, return v with smallest angle to up
+		if (v1.CCW && v2.CCW) {
+			return v1.dot > v2.dot;
+		// Return the one that rotates CCW
+		} else if (v1.CCW) {
+			return true;
+		} else if (v2.CCW) {
+			return false;
+
+		// If both CW, return v with largest angle to up
+		} else {
+			return v1.dot < v2.dot;
+		}
+	}
+
+	void setCCW_dot() {
+		glm::vec3 outCenter(glm::normalize(center));
+		glm::vec3 upNorm(glm::normalize(top - center));
+		glm::vec3 dirNorm(glm::normalize(point - center));
+
+		glm::vec3 normal(glm::normalize(glm::cross(upNorm, dirNorm)));
+
+		float normDot(glm::dot(normal, glm::normalize(center - outCenter)));
+
+		CCW = normDot < 0.0f;
+		dot = glm::dot(upNorm, dirNorm);
+	}
+};
+
+void comparatorSortCell(const std::vector<glm::vec3>& vertices, uint32_t* begin, uint32_t* end)
+{
+	if (begin == end)
+		return;
+
+	glm::vec3 center(0.0f);
+	for (uint32_t* idx = begin; idx != end; idx++)
+		center += vertices[*idx];
+	center /= static_cast<float>(end - begin);
+
+	std::vector<polyVec> polyVecs;
+	for (uint32_t* idx = begin; idx != end; idx++)
+		polyVecs.push_back(polyVec(vertices[*idx], center, vertices[*begin], *idx));
+	std::sort(polyVecs.begin(), polyVecs.end(), polyVec::compare);
+
+	for (size_t j = 0; j < polyVecs.size(); j++)
+		begin[j] = static_cast<uint32_t>(polyVecs[j].idx);
+}
+
+std::vector<glm::vec3> relaxedPoints(unsigned num_points, unsigned relax_iterations)
+{
+	std::vector<glm::vec3> points;
+	points.reserve(num_points);
+	for (unsigned i = 0; i < num_points; i++)
+		points.push_back(glm::normalize(glm::ballRand(1.0f)));
+
+	for (unsigned i = 0; i < relax_iterations; i++)
+	{
+		Voronoi v(points);
+		points = v.getCenters(points);
+		for (glm::vec3& p : points)
+			p = glm::normalize(p);
+	}
+	return points;
+}
+
+// Best wall time of repeat runs, in milliseconds
+double bestTime(unsigned repeat, const std::function<void()>& run)
+{
+	using clock = std::chrono::steady_clock;
+	double best = 0.0;
+	for (unsigned i = 0; i < repeat; i++)
+	{
+		auto start = clock::now();
+		run();
+		std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+		if (i == 0 || elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+// Same cyclic order, whatever vertex each cell starts at
+bool sameCycle(const uint32_t* a, const uint32_t* b, size_t size)
+{
+	size_t start = std::find(b, b + size, a[0]) - b;
+	for (size_t j = 0; j < size; j++)
+		if (a[j] != b[(start + j) % size])
+			return false;
+	return true;
+}
+
+// Ordering the vertices of every Voronoi cell, starting from the order the
+// cells are grouped in (increasing triangle index), against walking the hull
+// triangles around each point, which groups and orders the cells in one go
+void benchCellOrder(const std::vector<glm::vec3>& points, unsigned repeat)
+{
+	HullTriangulation hull;
+	Voronoi voronoi(points, &hull);
+	std::vector<glm::vec3> vertices;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> grouped;
+	voronoi.moveVerticesCells(vertices, offsets, grouped);
+	size_t num_cells = offsets.size() - 1;
+	for (size_t i = 0; i < num_cells; i++)
+		std::sort(grouped.begin() + offsets[i], grouped.begin() + offsets[i + 1]);
+
+	std::vector<uint32_t> by_comparator;
+	double comparator_ms = bestTime(repeat, [&]() {
+		by_comparator = grouped;
+		for (size_t i = 0; i < num_cells; i++)
+			comparatorSortCell(vertices, &by_comparator[offsets[i]], &by_comparator[0] + offsets[i + 1]);
+	});
+
+	std::vector<uint32_t> by_angle;
+	double angle_ms = bestTime(repeat, [&]() {
+		by_angle = grouped;
+		for (size_t i = 0; i < num_cells; i++)
+			Voronoi::sortCell(vertices, &by_angle[offsets[i]], &by_angle[0] + offsets[i + 1]);
+	});
+
+	std::vector<uint32_t> walk_offsets;
+	std::vector<uint32_t> by_walk;
+	std::vector<uint32_t> neighbors;
+	double walk_ms = bestTime(repeat, [&]() {
+		hull.walkCells(points.size(), walk_offsets, by_walk, neighbors);
+	});
+
+	size_t angle_mismatches = 0;
+	size_t walk_mismatches = 0;
+	for (size_t i = 0; i < num_cells; i++)
+	{
+		size_t size = offsets[i + 1] - offsets[i];
+		if (size == 0)
+			continue;
+		if (!std::equal(by_comparator.begin() + offsets[i], by_comparator.begin() + offsets[i + 1], by_angle.begin() + offsets[i]))
+			angle_mismatches++;
+		if (!sameCycle(&by_walk[walk_offsets[i]], &by_angle[offsets[i]], size))
+			walk_mismatches++;
+	}
+
+	std::cout << "cell_order " << points.size() << " regions: comparator sort " << comparator_ms << " ms, angle keys "
+	          << angle_ms << " ms (" << angle_mismatches << " cells differ), hull walk " << walk_ms << " ms ("
+	          << walk_mismatches << " cells differ from angle keys)" << std::endl;
+}
+
+// Circumcenter through the 3x3 system of the tetrahedron (origin, a, b, c),
+// how the Voronoi vertices were computed before the cross product kernel
+glm::vec3 matrixCircumcenter(const glm::vec3& x1, const glm::vec3& x2, const glm::vec3& x3)
+{
+	glm::mat3 A(glm::transpose(glm::mat3(x1, x2, x3)));
+	glm::vec3 B(0.5f * glm::vec3(glm::dot(x1, x1), glm::dot(x2, x2), glm::dot(x3, x3)));
+	return glm::normalize(glm::inverse(A) * B);
+}
+
+// Largest distance of the vertices from the double precision normals
+double maxError(const std::vector<glm::dvec3>& reference, const std::vector<glm::vec3>& vertices)
+{
+	double max_error = 0.0;
+	for (size_t i = 0; i < vertices.size(); i++)
+		max_error = std::max(max_error, glm::length(reference[i] - glm::dvec3(vertices[i].x, vertices[i].y, vertices[i].z)));
+	return max_error;
+}
+
+// Largest distance the circumcenters may be from the double precision ones.
+// The float kernels measure about 1.5e-7 at 10k regions and 5.3e-7 at 100k.
+const double kMaxCircumcenterError = 1e-6;
+
+// Voronoi vertices of every hull triangle: the scalar circumcenter against the
+// batched SIMD kernel, and both against the old matrix inverse for precision.
+// Returns false if the SIMD kernel differs from the scalar one or is less
+// precise than kMaxCircumcenterError.
+bool benchCircumcenter(const std::vector<glm::vec3>& points, unsigned repeat)
+{
+	HullTriangulation hull;
+	Voronoi voronoi(points, &hull);
+	const std::vector<glm::uvec3>& triangles = hull.triangles;
+	size_t num_tris = triangles.size();
+
+	std::vector<glm::dvec3> reference(num_tris);
+	for (size_t i = 0; i < num_tris; i++)
+	{
+		glm::dvec3 a(points[triangles[i][0]].x, points[triangles[i][0]].y, points[triangles[i][0]].z);
+		glm::dvec3 b(points[triangles[i][1]].x, points[triangles[i][1]].y, points[triangles[i][1]].z);
+		glm::dvec3 c(points[triangles[i][2]].x, points[triangles[i][2]].y, points[triangles[i][2]].z);
+		glm::dvec3 normal(glm::cross(b - a, c - a));
+		if (glm::dot(normal, a + b + c) < 0.0)
+			normal = -normal;
+		reference[i] = glm::normalize(normal);
+	}
+
+	std::vector<glm::vec3> by_matrix(num_tris);
+	double matrix_ms = bestTime(repeat, [&]() {
+		for (size_t i = 0; i < num_tris; i++)
+			by_matrix[i] = matrixCircumcenter(points[triangles[i][0]], points[triangles[i][1]], points[triangles[i][2]]);
+	});
+
+	std::vector<glm::vec3> by_scalar(num_tris);
+	double scalar_ms = bestTime(repeat, [&]() {
+		for (size_t i = 0; i < num_tris; i++)
+			by_scalar[i] = circumcenter(points[triangles[i][0]], points[triangles[i][1]], points[triangles[i][2]]);
+	});
+
+	std::vector<glm::vec3> by_simd(num_tris);
+	double simd_ms = bestTime(repeat, [&]() {
+		circumcenters(points.data(), triangles.data(), num_tris, by_simd.data());
+	});
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < num_tris; i++)
+		if (by_scalar[i] != by_simd[i])
+			mismatches++;
+
+	std::cout << "circumcenter " << points.size() << " regions, " << num_tris << " triangles: matrix inverse "
+	          << matrix_ms << " ms (max error " << maxError(reference, by_matrix) << "), scalar " << scalar_ms
+	          << " ms (max error " << maxError(reference, by_scalar) << "), " << circumcenterInstructionSet() << " "
+	          << simd_ms << " ms (" << mismatches << " differ from scalar)" << std::endl;
+
+	double simd_error = maxError(reference, by_simd);
+	if (mismatches != 0 || simd_error > kMaxCircumcenterError) {
+		std::cerr << "FAIL: " << circumcenterInstructionSet() << " circumcenters have " << mismatches
+		          << " differing from scalar and max error " << simd_error << ", more than " << kMaxCircumcenterError << "\n";
+		return false;
+	}
+	return true;
+}
+
+// Elevation noise at every point: one fractal() call per point against the
+// batched SIMD fractal() over all of them, and the batch with the octaves
+// below the noise tolerance skipped
+void benchNoise(const std::vector<glm::vec3>& points, unsigned repeat)
+{
+	const SimplexNoise sn(el_frequency, el_amplitude, el_lacunarity, el_persistence, 8675309);
+	const SimplexNoise culled(el_frequency, el_amplitude, el_lacunarity, el_persistence, 8675309, el_tolerance);
+	size_t num_points = points.size();
+	std::vector<float> xs(num_points), ys(num_points), zs(num_points);
+	for (size_t i = 0; i < num_points; i++)
+	{
+		xs[i] = points[i].x;
+		ys[i] = points[i].y;
+		zs[i] = points[i].z;
+	}
+
+	std::vector<float> by_point(num_points);
+	double point_ms = bestTime(repeat, [&]() {
+		for (size_t i = 0; i < num_points; i++)
+			by_point[i] = sn.fractal(el_octaves, xs[i], ys[i], zs[i]);
+	});
+
+	std::vector<float> by_batch(num_points);
+	double batch_ms = bestTime(repeat, [&]() {
+		sn.fractal(el_octaves, xs.data(), ys.data(), zs.data(), by_batch.data(), num_points);
+	});
+
+	std::vector<float> by_culled(num_points);
+	double culled_ms = bestTime(repeat, [&]() {
+		culled.fractal(el_octaves, xs.data(), ys.data(), zs.data(), by_culled.data(), num_points);
+	});
+
+	size_t mismatches = 0;
+	float max_error = 0.0f;
+	for (size_t i = 0; i < num_points; i++)
+	{
+		if (by_point[i] != by_batch[i])
+			mismatches++;
+		max_error = std::max(max_error, std::abs(by_culled[i] - by_point[i]));
+	}
+
+	std::cout << "noise " << num_points << " regions, " << el_octaves << " octaves: per point " << point_ms
+	          << " ms, batch " << batch_ms << " ms (" << mismatches << " differ from per point), batch of "
+	          << culled.effectiveOctaves(el_octaves) << " octaves " << culled_ms << " ms (max error " << max_error
+	          << ")" << std::endl;
+}
+
+// QuickHull with a fresh QuickHull object and output mesh every time, as
+// before hull workspaces, against one workspace reused for every run. The
+// allocations are those of the last run, once the workspace is warmed up.
+// Returns false if that run allocated, as hulls with a warm workspace must not.
+bool benchHull(const std::vector<glm::vec3>& points, unsigned repeat)
+{
+	const float eps = 0.000001f;
+	size_t fresh_allocations = 0, fresh_bytes = 0;
+	size_t num_faces = 0;
+	double fresh_ms = bestTime(repeat, [&]() {
+		size_t allocations = allocationCount(), bytes = allocationBytes();
+		quickhull::QuickHull<float, uint32_t> qh;
+		qh.setParallel(true);
+		auto mesh = qh.getConvexHullAsMesh(&points[0].x, points.size(), false, eps);
+		num_faces = mesh.m_faces.size();
+		fresh_allocations = allocationCount() - allocations;
+		fresh_bytes = allocationBytes() - bytes;
+	});
+
+	HullWorkspace workspace;
+	workspace.quickhull.setParallel(true);
+	size_t reused_allocations = 0, reused_bytes = 0;
+	size_t reused_faces = 0;
+	double reused_ms = bestTime(repeat + 1, [&]() {
+		size_t allocations = allocationCount(), bytes = allocationBytes();
+		workspace.quickhull.getConvexHullAsMesh(&points[0].x, points.size(), false, workspace.mesh, eps);
+		reused_faces = workspace.mesh.m_faces.size();
+		reused_allocations = allocationCount() - allocations;
+		reused_bytes = allocationBytes() - bytes;
+	});
+
+	const double MiB = 1024.0 * 1024.0;
+	std::cout << "hull " << points.size() << " regions, " << num_faces << " triangles: fresh " << fresh_ms << " ms ("
+	          << fresh_allocations << " allocations, " << fresh_bytes / MiB << " MiB), reused workspace " << reused_ms
+	          << " ms (" << reused_allocations << " allocations, " << reused_bytes / MiB << " MiB"
+	          << (reused_faces == num_faces ? "" : ", different hull") << ")" << std::endl;
+
+	if (reused_allocations != 0) {
+		std::cerr << "FAIL: hull with a reused workspace made " << reused_allocations << " allocations\n";
+		return false;
+	}
+	return true;
+}
+
+bool lessFace(const glm::uvec3& a, const glm::uvec3& b)
+{
+	return a[0] != b[0] ? a[0] < b[0] : a[1] != b[1] ? a[1] < b[1] : a[2] < b[2];
+}
+
+// Hull faces with the corners of each sorted, in sorted order, to compare
+// hulls that number and wind their triangles differently
+std::vector<glm::uvec3> canonicalFaces(std::vector<glm::uvec3> faces)
+{
+	for (glm::uvec3& f : faces)
+	{
+		std::sort(&f[0], &f[0] + 3);
+	}
+	std::sort(faces.begin(), faces.end(), lessFace);
+	return faces;
+}
+
+// QuickHull against the spherical Delaunay triangulation, both with a reused
+// workspace. The hulls can differ where four points are almost cocircular:
+// QuickHull's tolerance accepts either diagonal of such a quad, the Delaunay
+// flips pick the one with the empty circumcircle.
+void benchDelaunay(const std::vector<glm::vec3>& points, unsigned repeat)
+{
+	HullWorkspace workspace;
+	workspace.quickhull.setParallel(true);
+	double quickhull_ms = bestTime(repeat + 1, [&]() {
+		workspace.quickhull.getConvexHullAsMesh(&points[0].x, points.size(), false, workspace.mesh, 0.000001f);
+	});
+
+	bool triangulated = true;
+	double delaunay_ms = bestTime(repeat + 1, [&]() {
+		triangulated = workspace.topology.triangulate(points) && triangulated;
+	});
+
+	std::vector<glm::uvec3> quickhull_faces, delaunay_faces;
+	Voronoi(points, nullptr, &workspace, HullAlgorithm::QuickHull).moveHullFaces(quickhull_faces);
+	Voronoi(points, nullptr, &workspace, HullAlgorithm::SphereDelaunay).moveHullFaces(delaunay_faces);
+	quickhull_faces = canonicalFaces(quickhull_faces);
+	delaunay_faces = canonicalFaces(delaunay_faces);
+	std::vector<glm::uvec3> differing;
+	std::set_difference(quickhull_faces.begin(), quickhull_faces.end(), delaunay_faces.begin(), delaunay_faces.end(),
+	                    std::back_inserter(differing), lessFace);
+
+	std::cout << "delaunay " << points.size() << " regions: QuickHull " << quickhull_ms << " ms, sphere Delaunay "
+	          << delaunay_ms << " ms (" << quickhull_ms / delaunay_ms << "x)"
+	          << ", " << differing.size() << " of " << quickhull_faces.size() << " triangles differ"
+	          << (triangulated ? "" : ", fell back to QuickHull") << std::endl;
+}
+
+bool sameMesh(const Mesh& a, const Mesh& b)
+{
+	return a.hull_points == b.hull_points && a.hull_indices == b.hull_indices && a.hull_faces == b.hull_faces &&
+	       a.vertices == b.vertices && a.lines == b.lines && a.faces == b.faces &&
+	       a.regions.center_indices == b.regions.center_indices && a.regions.cell_offsets == b.regions.cell_offsets &&
+	       a.regions.cell_counts == b.regions.cell_counts && a.regions.elevation_multipliers == b.regions.elevation_multipliers &&
+	       a.region_neighbor_offsets == b.region_neighbor_offsets && a.region_neighbors == b.region_neighbors &&
+	       a.cell_vertex_indices == b.cell_vertex_indices;
+}
+
+// Generating a planet once against storing it in a planet cache and loading
+// it back, which is what reopening the same planet costs with the cache:
+// copied into a Mesh, or only mapped as planets does to draw it
+void benchCache(unsigned num_regions, unsigned relax_iterations, unsigned repeat, const std::string& cache_dir)
+{
+	GenerationParams params;
+	params.num_regions = num_regions;
+	params.relax_iterations = relax_iterations;
+
+	Mesh generated;
+	double generate_ms = bestTime(1, [&]() { generated = Mesh(params); });
+
+	bool stored = true;
+	double store_ms = bestTime(repeat, [&]() { stored = storeCachedPlanet(cache_dir, params, generated) && stored; });
+
+	std::string filename = planetCacheFilename(cache_dir, params);
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	double file_mib = file ? static_cast<double>(file.tellg()) / (1024.0 * 1024.0) : 0.0;
+	file.close();
+
+	Mesh loaded;
+	bool hit = true;
+	double load_ms = bestTime(repeat, [&]() { hit = loadCachedPlanet(cache_dir, params, loaded) && hit; });
+
+	PlanetFileView view;
+	bool mapped = true;
+	double map_ms = bestTime(repeat, [&]() { mapped = openCachedPlanet(cache_dir, params, view) && mapped; });
+	view.close();
+	std::remove(filename.c_str());
+
+	std::cout << "cache " << num_regions << " regions: generate " << generate_ms << " ms, store " << store_ms << " ms ("
+	          << file_mib << " MiB), load " << load_ms << " ms ("
+	          << (!stored ? "store failed" : !hit ? "load failed" : sameMesh(generated, loaded) ? "identical" : "different planet")
+	          << "), map " << map_ms << " ms" << (mapped ? "" : " (map failed)") << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> benchmarks;
+	std::vector<unsigned> region_counts;
+	unsigned relax_iterations;
+	unsigned repeat;
+	std::string cache_dir;
+
+	try {
+		po::options_description desc("Allowed options");
+		desc.add_options()
+			("help,h", "Display help message")
+			("bench,b", po::value<std::vector<std::string>>(&benchmarks)->multitoken(), "Benchmarks to run: cell_order, circumcenter, noise, hull, delaunay, cache. Runs all of them by default")
+			("regions,r", po::value<std::vector<unsigned>>(&region_counts)->multitoken(), "Region counts to run each benchmark at, 10000 and 100000 by default")
+			("relax", po::value<unsigned>(&relax_iterations)->default_value(1), "Lloyd relaxation iterations applied to the random points")
+			("repeat", po::value<unsigned>(&repeat)->default_value(5), "Runs per measurement, the fastest one is reported")
+			("cache_dir", po::value<std::string>(&cache_dir)->default_value("planetbench_cache"), "Directory the cache benchmark stores its planets in")
+		;
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+
+		if (vm.count("help")) {
+			std::cout << desc << "\n";
+			return 0;
+		}
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << "\n";
+		return 1;
+	}
+
+	if (benchmarks.empty())
+		benchmarks = {"cell_order", "circumcenter", "noise", "hull", "delaunay", "cache"};
+	if (region_counts.empty())
+		region_counts = {10000, 100000};
+	if (repeat == 0)
+		repeat = 1;
+
+	bool passed = true;
+	for (unsigned num_regions : region_counts) {
+		std::vector<glm::vec3> points(relaxedPoints(num_regions, relax_iterations));
+		for (const std::string& bench : benchmarks) {
+			if (bench == "cell_order") {
+				benchCellOrder(points, repeat);
+			} else if (bench == "circumcenter") {
+				passed = benchCircumcenter(points, repeat) && passed;
+			} else if (bench == "noise") {
+				benchNoise(points, repeat);
+			} else if (bench == "hull") {
+				passed = benchHull(points, repeat) && passed;
+			} else if (bench == "delaunay") {
+				benchDelaunay(points, repeat);
+			} else if (bench == "cache") {
+				benchCache(num_regions, relax_iterations, repeat, cache_dir);
+			} else {
+				std::cerr << "Unknown benchmark " << bench << "\n";
+				return 1;
+			}
+		}
+	}
+	return passed ? 0 : 1;
+}
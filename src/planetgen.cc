@@ -0,0 +1,146 @@
+#include "allocation_stats.h"
+#include "biome.h"
+#include "config.h"
+#include "exporter.h"
+#include "hull_workspace.h"
+#include "mesh.h"
+#include "planet_cache.h"
+#include "planet_file.h"
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Headless planet generator: builds planets without creating a window or an
+// OpenGL context, so it can run on machines without a display or GPU.
+
+// Output file for one planet of a batch, e.g. planet.obj -> planet_8675309.obj
+std::string batchFilename(const std::string& output, unsigned seed, unsigned count)
+{
+	if (count == 1)
+		return output;
+	return suffixedFilename(output, std::to_string(seed));
+}
+
+int main(int argc, char* argv[])
+{
+	GenerationParams params;
+	unsigned count;
+	std::string output;
+	std::string planet_file;
+	std::string hull_algorithm;
+	std::string cache_dir;
+	int height_param;
+	bool stats;
+
+	try {
+		po::options_description desc("Allowed options");
+		desc.add_options()
+			("help,h", "Display help message")
+			("regions,r", po::value<unsigned>(&params.num_regions)->default_value(10000), "Set the number of regions, at least 500")
+			("seed,s", po::value<unsigned>(&params.noise_seed)->default_value(8675309), "Set the seed for the planet's points and height noise, between 0 and 4,294,967,295")
+			("relax", po::value<unsigned>(&params.relax_iterations)->default_value(1), "Set the number of Lloyd relaxation iterations used to space out the regions")
+			("rebuild_hull", "Rebuild the convex hull from scratch on every relaxation iteration instead of repairing the previous one")
+			("hull_algorithm", po::value<std::string>(&hull_algorithm)->default_value("quickhull"), "Algorithm for new convex hulls: quickhull, or delaunay for the faster spherical Delaunay triangulation")
+			("count,n", po::value<unsigned>(&count)->default_value(1), "Number of planets to generate, using consecutive seeds starting at --seed")
+			("output", po::value<std::string>(&output), "Write each planet to this file: PLY with elevations and colors for .ply, binary glTF with the same for .glb, Wavefront OBJ otherwise. With --count, the seed is appended to the file name")
+			("ocean_ht,o", po::value<int>(&height_param)->default_value(120), "Set the height of the ocean that exported elevations and colors are relative to, between 0 (everything terrain) and 200 (everything underwater)")
+			("planet_file", po::value<std::string>(&planet_file), "Write each planet to this planet file, which planets --planet_file shows without generating it. With --count, the seed is appended to the file name")
+			("cache_dir", po::value<std::string>(&cache_dir), "Load planets generated before from this directory instead of generating them again, and store new ones in it")
+			("stats", po::bool_switch(&stats), "Print the number and total size of heap allocations made while generating each planet, and the noise octaves evaluated")
+		;
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+
+		if (vm.count("help")) {
+			std::cout << desc << "\n";
+			return 0;
+		}
+
+		if (params.num_regions < kMinRegions || params.num_regions > kMaxHeadlessRegions) {
+			std::cerr << "Invalid number of regions. Must be in range [" << kMinRegions << "-" << kMaxHeadlessRegions << "]\n";
+			return 1;
+		}
+
+		if (vm.count("rebuild_hull")) params.incremental_relax = false;
+
+		if (hull_algorithm == "delaunay") {
+			params.hull_algorithm = HullAlgorithm::SphereDelaunay;
+		} else if (hull_algorithm != "quickhull") {
+			std::cerr << "Invalid hull algorithm " << hull_algorithm << ".\n";
+			return 1;
+		}
+
+		if (height_param < 0 || height_param > 200) {
+			std::cerr << "Invalid ocean height parameter.\n";
+			return 1;
+		}
+
+		if (count == 0) {
+			std::cerr << "Invalid planet count.\n";
+			return 1;
+		}
+	} catch (std::exception& e) {
+		std::cerr << "error: " << e.what() << "\n";
+		return 1;
+	}
+
+	using clock = std::chrono::steady_clock;
+	std::chrono::duration<double> total(0.0);
+
+	BiomeParams biome;
+	biome.ocean_height = oceanHeight(height_param);
+
+	// Shared by the planets so their hull computations reuse its buffers
+	HullWorkspace workspace;
+
+	for (unsigned i = 0; i < count; i++) {
+		GenerationParams planet_params(params);
+		planet_params.noise_seed = params.noise_seed + i;
+		unsigned seed = planet_params.noise_seed;
+
+		size_t allocations_before = allocationCount();
+		size_t bytes_before = allocationBytes();
+
+		auto start = clock::now();
+		Mesh planet(cachedPlanet(planet_params, cache_dir, &workspace));
+		std::chrono::duration<double> elapsed = clock::now() - start;
+		total += elapsed;
+
+		size_t allocations = allocationCount() - allocations_before;
+		size_t bytes = allocationBytes() - bytes_before;
+
+		std::cout << "Planet " << seed << ": " << planet.vertices.size() << " vertices, "
+		          << planet.faces.size() << " faces in " << elapsed.count() << " s" << std::endl;
+		if (stats) {
+			std::cout << "  " << allocations << " allocations, " << bytes / (1024.0 * 1024.0) << " MiB" << std::endl;
+			std::cout << "  " << planet.stats.noise_octaves_evaluated << " of " << planet.stats.noise_octaves_requested
+			          << " noise octaves evaluated" << std::endl;
+		}
+
+		if (!output.empty()) {
+			std::string filename = batchFilename(output, seed, count);
+			if (!exportPlanet(planet, biome, filename)) {
+				std::cerr << "Failed to write " << filename << "\n";
+				return 1;
+			}
+		}
+
+		if (!planet_file.empty()) {
+			std::string filename = batchFilename(planet_file, seed, count);
+			if (!writePlanetFile(planet, planet_params, filename)) {
+				std::cerr << "Failed to write " << filename << "\n";
+				return 1;
+			}
+		}
+	}
+
+	std::cout << "Generated " << count << " planet(s) in " << total.count() << " s ("
+	          << total.count() / count << " s per planet)" << std::endl;
+	return 0;
+}
@@ -280,6 +280,19 @@ void RenderPass::updateVBO(int position, const void* data, size_t size)
 				data, GL_STATIC_DRAW));
 }
 
+void RenderPass::updateIndex(const void* data, size_t size)
+{
+	if (!input_.hasIndex())
+		throw __func__+std::string(": error, the render pass has no index buffer");
+	auto meta = input_.getIndexMeta();
+	// The element array binding belongs to the VAO
+	CHECK_GL_ERROR(glBindVertexArray(vao_));
+	CHECK_GL_ERROR(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glbuffers_.back()));
+	CHECK_GL_ERROR(glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+				size * meta.getElementSize(),
+				data, GL_STATIC_DRAW));
+}
+
 void RenderPass::setup()
 {
 	// Switch to our object VAO.
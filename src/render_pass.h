@@ -92,6 +92,7 @@ public:
 
 	unsigned getVAO() const { return unsigned(vao_); }
 	void updateVBO(int position, const void* data, size_t nelement);
+	void updateIndex(const void* data, size_t nelement);
 	void setup();
 	/*
  	 * Note: here we don't have an unified render() function, because the
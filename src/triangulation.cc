@@ -0,0 +1,444 @@
+#include "triangulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const uint32_t kNoEdge = 0xFFFFFFFF;
+
+// Relative tolerance for the convexity test, so edges between (almost)
+// cocircular points aren't flipped back and forth
+const double kFlipEpsilon = 1e-9;
+
+// Points closer than this to an inserted point are left out of a new
+// triangulation, the same tolerance Voronoi gives QuickHull
+const float kDuplicateDistance = 0.000001f;
+
+inline uint32_t next(uint32_t he) { return he - he % 3 + (he + 1) % 3; }
+inline uint32_t prev(uint32_t he) { return he - he % 3 + (he + 2) % 3; }
+
+inline glm::dvec3 toDouble(const glm::vec3& v) { return glm::dvec3(v.x, v.y, v.z); }
+
+// Signed volume of the tetrahedron (origin, a, b, c)
+inline double volume(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c) { return glm::dot(a, glm::cross(b, c)); }
+
+// Spread the low 10 bits of v out to every third bit
+inline uint32_t spreadBits(uint32_t v)
+{
+	v &= 0x3FF;
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+// Position of a point along a Z-order curve through the cube around the
+// sphere, so that points close on the curve are close on the sphere
+inline uint32_t mortonCode(const glm::vec3& p)
+{
+	uint32_t x = static_cast<uint32_t>(std::min(std::max((p.x + 1.0f) * 512.0f, 0.0f), 1023.0f));
+	uint32_t y = static_cast<uint32_t>(std::min(std::max((p.y + 1.0f) * 512.0f, 0.0f), 1023.0f));
+	uint32_t z = static_cast<uint32_t>(std::min(std::max((p.z + 1.0f) * 512.0f, 0.0f), 1023.0f));
+	return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+}
+
+void HullTriangulation::clear()
+{
+	triangles.clear();
+	opposite.clear();
+	flips_ = 0;
+}
+
+bool HullTriangulation::build(const std::vector<glm::uvec3>& hull_triangles, const std::vector<uint32_t>& hull_opposite, const std::vector<glm::vec3>& points)
+{
+	triangles = hull_triangles;
+	opposite = hull_opposite;
+	size_t num_edges = triangles.size() * 3;
+
+	// Every half-edge needs a twin running the other way
+	bool closed = !triangles.empty() && opposite.size() == num_edges;
+	for (uint32_t he = 0; closed && he < num_edges; he++)
+	{
+		uint32_t twin = opposite[he];
+		closed = twin < num_edges && opposite[twin] == he &&
+		         triangles[twin / 3][twin % 3] == triangles[he / 3][(he + 1) % 3] &&
+		         triangles[twin / 3][(twin + 1) % 3] == triangles[he / 3][he % 3];
+	}
+	if (!closed)
+	{
+		triangles.clear();
+		opposite.clear();
+		return false;
+	}
+
+	// Hull triangles all wind the same way, so one of them is enough
+	const glm::uvec3& tri = triangles[0];
+	winding_ = 1;
+	winding_ = orientation(points, tri[0], tri[1], tri[2]) > 0.0 ? 1 : -1;
+	flips_ = 0;
+	return true;
+}
+
+bool HullTriangulation::triangulate(const std::vector<glm::vec3>& points)
+{
+	clear();
+	winding_ = 1;
+	uint32_t num_points = static_cast<uint32_t>(points.size());
+	if (num_points < 6)
+		return false;
+
+	// Points furthest along +x, -x, +y, -y, +z and -z
+	uint32_t extremes[6] = {0, 0, 0, 0, 0, 0};
+	for (uint32_t i = 1; i < num_points; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (points[i][axis] > points[extremes[2 * axis]][axis])
+				extremes[2 * axis] = i;
+			if (points[i][axis] < points[extremes[2 * axis + 1]][axis])
+				extremes[2 * axis + 1] = i;
+		}
+	}
+	// The insertion works on the directions of the points, see isLocallyDelaunay()
+	directions_.resize(num_points);
+	for (uint32_t i = 0; i < num_points; i++)
+		directions_[i] = glm::normalize(toDouble(points[i]));
+
+	std::vector<bool> inserted(num_points, false);
+	for (uint32_t e : extremes)
+	{
+		if (inserted[e])
+			return false;
+		inserted[e] = true;
+	}
+
+	// Their octahedron, counter-clockwise seen from outside. It has to
+	// surround the origin so that every other point is above one of its
+	// triangles.
+	const uint32_t px = extremes[0], nx = extremes[1], py = extremes[2], ny = extremes[3], pz = extremes[4], nz = extremes[5];
+	triangles.reserve(2 * num_points);
+	opposite.reserve(6 * num_points);
+	triangles.assign({
+		glm::uvec3(px, py, pz), glm::uvec3(py, nx, pz), glm::uvec3(nx, ny, pz), glm::uvec3(ny, px, pz),
+		glm::uvec3(py, px, nz), glm::uvec3(nx, py, nz), glm::uvec3(ny, nx, nz), glm::uvec3(px, ny, nz)
+	});
+	for (const glm::uvec3& tri : triangles)
+	{
+		if (orientation(points, tri[0], tri[1], tri[2]) <= 0.0)
+		{
+			clear();
+			return false;
+		}
+	}
+	opposite.assign(triangles.size() * 3, kNoEdge);
+	for (uint32_t he = 0; he < opposite.size(); he++)
+		for (uint32_t twin = 0; twin < opposite.size(); twin++)
+			if (triangles[twin / 3][twin % 3] == triangles[he / 3][(he + 1) % 3] &&
+			    triangles[twin / 3][(twin + 1) % 3] == triangles[he / 3][he % 3])
+				opposite[he] = twin;
+
+	// Insert the rest along a space filling curve, so each point's triangle
+	// is a short walk from the previous point's
+	std::vector<uint64_t> order;
+	order.reserve(num_points);
+	for (uint32_t i = 0; i < num_points; i++)
+		if (!inserted[i])
+			order.push_back((static_cast<uint64_t>(mortonCode(points[i])) << 32) | i);
+	std::sort(order.begin(), order.end());
+
+	std::vector<uint32_t> stack;
+	uint32_t triangle = 0;
+	for (uint64_t key : order)
+	{
+		if (!insert(points, static_cast<uint32_t>(key), triangle, stack))
+		{
+			clear();
+			return false;
+		}
+	}
+
+	// Flips can't always fix the triangles of points inserted right on an edge
+	for (const glm::uvec3& tri : triangles)
+	{
+		if (orientation(points, tri[0], tri[1], tri[2]) <= 0.0)
+		{
+			clear();
+			return false;
+		}
+	}
+	flips_ = 0;
+	return true;
+}
+
+// Split the triangle under a point into three around it, then flip the edges
+// facing the point until they're all convex again. triangle is where the walk
+// to the point starts, and is left at one of the point's triangles.
+bool HullTriangulation::insert(const std::vector<glm::vec3>& points, uint32_t point, uint32_t& triangle, std::vector<uint32_t>& stack)
+{
+	// Walk across edges the point is on the far side of, as seen from the
+	// origin, until it is above the triangle
+	const glm::dvec3& p = directions_[point];
+	size_t max_steps = triangles.size();
+	for (size_t steps = 0;; steps++)
+	{
+		const glm::uvec3& tri = triangles[triangle];
+		bool outside[3];
+		for (int i = 0; i < 3; i++)
+			outside[i] = volume(directions_[tri[i]], directions_[tri[(i + 1) % 3]], p) < 0.0;
+		if (!outside[0] && !outside[1] && !outside[2])
+			break;
+		if (steps == max_steps)
+			return false;
+		// Start from a different edge each step so the walk can't cycle
+		int edge = static_cast<int>(steps % 3);
+		while (!outside[edge])
+			edge = (edge + 1) % 3;
+		triangle = opposite[3 * triangle + edge] / 3;
+	}
+
+	const glm::uvec3 tri = triangles[triangle];
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec3 d(points[point] - points[tri[i]]);
+		if (glm::dot(d, d) < kDuplicateDistance * kDuplicateDistance)
+			return true;
+	}
+
+	// (a, b, c) becomes (a, b, p), (b, c, p) and (c, a, p), with the first
+	// staying in the old slot
+	uint32_t t0 = triangle;
+	uint32_t t1 = static_cast<uint32_t>(triangles.size());
+	uint32_t t2 = t1 + 1;
+	uint32_t out_bc = opposite[3 * t0 + 1];
+	uint32_t out_ca = opposite[3 * t0 + 2];
+	triangles[t0] = glm::uvec3(tri[0], tri[1], point);
+	triangles.push_back(glm::uvec3(tri[1], tri[2], point));
+	triangles.push_back(glm::uvec3(tri[2], tri[0], point));
+	opposite.resize(opposite.size() + 6);
+	link(3 * t1, out_bc);
+	link(3 * t2, out_ca);
+	link(3 * t0 + 1, 3 * t1 + 2);
+	link(3 * t1 + 1, 3 * t2 + 2);
+	link(3 * t2 + 1, 3 * t0 + 2);
+
+	// The edges facing the point are the first of each of its triangles. A
+	// flip leaves the point's two new triangles facing the edges prev(he)
+	// and next(twin).
+	stack.clear();
+	stack.push_back(3 * t0);
+	stack.push_back(3 * t1);
+	stack.push_back(3 * t2);
+	while (!stack.empty())
+	{
+		uint32_t he = stack.back();
+		stack.pop_back();
+
+		if (isLocallyDelaunay(he))
+			continue;
+
+		if (!flip(points, he))
+			return false;
+
+		stack.push_back(prev(he));
+		stack.push_back(next(opposite[he]));
+	}
+	triangle = t0;
+	return true;
+}
+
+bool HullTriangulation::repair(const std::vector<glm::vec3>& points, size_t max_flips)
+{
+	flips_ = 0;
+	if (triangles.empty())
+		return false;
+
+	// A triangle that turned over can't be fixed with flips
+	for (const glm::uvec3& tri : triangles)
+		if (orientation(points, tri[0], tri[1], tri[2]) <= 0.0)
+			return false;
+
+	// Check every edge once, then recheck the edges around each flip
+	std::vector<uint32_t> stack;
+	stack.reserve(opposite.size() / 2);
+	for (uint32_t he = 0; he < opposite.size(); he++)
+		if (he < opposite[he])
+			stack.push_back(he);
+
+	while (!stack.empty())
+	{
+		uint32_t he = stack.back();
+		stack.pop_back();
+
+		if (isLocallyConvex(points, he))
+			continue;
+
+		if (++flips_ > max_flips || !flip(points, he))
+			return false;
+
+		// The four outer edges of the flipped quad
+		uint32_t twin = opposite[he];
+		stack.push_back(next(he));
+		stack.push_back(prev(he));
+		stack.push_back(next(twin));
+		stack.push_back(prev(twin));
+	}
+	return true;
+}
+
+bool HullTriangulation::walkCells(size_t num_points, std::vector<uint32_t>& cell_offsets, std::vector<uint32_t>& cell_triangles, std::vector<uint32_t>& cell_neighbors) const
+{
+	// Size every cell by the number of half-edges ending at its point, and
+	// start each walk from the lowest of them
+	uint32_t num_edges = static_cast<uint32_t>(opposite.size());
+	std::vector<uint32_t> first_incoming(num_points, kNoEdge);
+	cell_offsets.assign(num_points + 1, 0);
+	for (uint32_t he = num_edges; he-- > 0;)
+	{
+		uint32_t end = triangles[he / 3][(he + 1) % 3];
+		cell_offsets[end + 1]++;
+		first_incoming[end] = he;
+	}
+	for (size_t i = 0; i < num_points; i++)
+		cell_offsets[i + 1] += cell_offsets[i];
+
+	cell_triangles.resize(num_edges);
+	cell_neighbors.resize(num_edges);
+
+	// Each cell is written to its own range, so the walks run in parallel
+	int num_cells = static_cast<int>(num_points);
+	bool fans = true;
+	#pragma omp parallel for reduction(&&:fans)
+	for (int i = 0; i < num_cells; i++)
+	{
+		uint32_t begin = cell_offsets[i];
+		uint32_t size = cell_offsets[i + 1] - begin;
+		uint32_t he = first_incoming[i];
+		for (uint32_t j = 0; j < size; j++)
+		{
+			if (j > 0 && he == first_incoming[i])
+			{
+				fans = false;
+				break;
+			}
+			cell_triangles[begin + j] = he / 3;
+
+			// he ends at the cell's point. With counter-clockwise triangles the
+			// next triangle counter-clockwise around the point is across the
+			// edge he starts on, otherwise across the edge after he.
+			if (winding_ > 0)
+			{
+				cell_neighbors[begin + j] = triangles[he / 3][he % 3];
+				he = prev(opposite[he]);
+			}
+			else
+			{
+				cell_neighbors[begin + j] = triangles[he / 3][(he + 2) % 3];
+				he = opposite[next(he)];
+			}
+		}
+		if (he != first_incoming[i])
+			fans = false;
+	}
+	return fans;
+}
+
+// Signed volume of the tetrahedron (origin, a, b, c), positive when the
+// triangle winds the same way as the rest of the hull
+double HullTriangulation::orientation(const std::vector<glm::vec3>& points, uint32_t a, uint32_t b, uint32_t c) const
+{
+	glm::dvec3 pa(toDouble(points[a]));
+	glm::dvec3 pb(toDouble(points[b]));
+	glm::dvec3 pc(toDouble(points[c]));
+	return winding_ * glm::dot(pa, glm::cross(pb, pc));
+}
+
+// An edge belongs to the convex hull if the far vertex of the neighbouring
+// triangle is below the plane of this triangle
+bool HullTriangulation::isLocallyConvex(const std::vector<glm::vec3>& points, uint32_t he) const
+{
+	const glm::uvec3& tri = triangles[he / 3];
+	uint32_t twin = opposite[he];
+	uint32_t far = triangles[twin / 3][(twin + 2) % 3];
+
+	glm::dvec3 a(toDouble(points[tri[he % 3]]));
+	glm::dvec3 b(toDouble(points[tri[(he + 1) % 3]]));
+	glm::dvec3 c(toDouble(points[tri[(he + 2) % 3]]));
+	glm::dvec3 d(toDouble(points[far]));
+
+	glm::dvec3 normal(glm::cross(b - a, c - a) * static_cast<double>(winding_));
+	double height = glm::dot(normal, d - a);
+	return height <= kFlipEpsilon * glm::length(normal) * glm::length(d - a);
+}
+
+// isLocallyConvex() for the directions of the points, i.e. the points
+// projected back onto the sphere. Normalized floats are off the unit sphere
+// by about as much as the height of a small triangle's neighbor above its
+// plane, so otherwise the test can disagree with the orientations of the
+// triangles, which only depend on the directions.
+bool HullTriangulation::isLocallyDelaunay(uint32_t he) const
+{
+	const glm::uvec3& tri = triangles[he / 3];
+	uint32_t twin = opposite[he];
+	uint32_t far = triangles[twin / 3][(twin + 2) % 3];
+
+	const glm::dvec3& a = directions_[tri[he % 3]];
+	const glm::dvec3& b = directions_[tri[(he + 1) % 3]];
+	const glm::dvec3& c = directions_[tri[(he + 2) % 3]];
+	const glm::dvec3& d = directions_[far];
+
+	glm::dvec3 normal(glm::cross(b - a, c - a) * static_cast<double>(winding_));
+	double height = glm::dot(normal, d - a);
+	return height <= kFlipEpsilon * glm::length(normal) * glm::length(d - a);
+}
+
+// Replace the edge a-b shared by (a, b, c) and (b, a, d) with c-d, giving
+// the triangles (c, a, d) and (d, b, c). Keeps the triangle slots, so he
+// and its twin become the new c-d edge.
+bool HullTriangulation::flip(const std::vector<glm::vec3>& points, uint32_t he)
+{
+	uint32_t twin = opposite[he];
+	uint32_t t1 = he / 3;
+	uint32_t t2 = twin / 3;
+
+	uint32_t a = triangles[t1][he % 3];
+	uint32_t b = triangles[t1][(he + 1) % 3];
+	uint32_t c = triangles[t1][(he + 2) % 3];
+	uint32_t d = triangles[t2][(twin + 2) % 3];
+
+	// Flipping must not turn either new triangle over
+	if (c == d || orientation(points, c, a, d) <= 0.0 || orientation(points, d, b, c) <= 0.0)
+		return false;
+
+	uint32_t out_bc = opposite[next(he)];
+	uint32_t out_ca = opposite[prev(he)];
+	uint32_t out_ad = opposite[next(twin)];
+	uint32_t out_db = opposite[prev(twin)];
+
+	// Rotate the new triangles so that he and twin stay the shared edge:
+	// t1 = (d, c, a) starting at he's slot, t2 = (c, d, b) starting at twin's slot
+	triangles[t1][he % 3] = d;
+	triangles[t1][(he + 1) % 3] = c;
+	triangles[t1][(he + 2) % 3] = a;
+	triangles[t2][twin % 3] = c;
+	triangles[t2][(twin + 1) % 3] = d;
+	triangles[t2][(twin + 2) % 3] = b;
+
+	// he: d->c, next(he): c->a, prev(he): a->d
+	// twin: c->d, next(twin): d->b, prev(twin): b->c
+	link(he, twin);
+	link(next(he), out_ca);
+	link(prev(he), out_ad);
+	link(next(twin), out_db);
+	link(prev(twin), out_bc);
+	return true;
+}
+
+void HullTriangulation::link(uint32_t he1, uint32_t he2)
+{
+	opposite[he1] = he2;
+	opposite[he2] = he1;
+}
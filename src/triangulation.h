@@ -0,0 +1,71 @@
+#ifndef TRIANGULATION_H
+#define TRIANGULATION_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Triangulation of points on the unit sphere with edge adjacency, i.e. the
+// convex hull of those points. Used to carry the hull from one relaxation
+// iteration to the next: the points only move a little, so the previous hull
+// is repaired with local edge flips instead of being rebuilt from scratch.
+//
+// Half-edge h = 3 * t + i goes from triangles[t][i] to triangles[t][(i+1) % 3].
+class HullTriangulation {
+public:
+	std::vector<glm::uvec3> triangles;
+	// Half-edge on the other side of each half-edge
+	std::vector<uint32_t> opposite;
+
+	bool empty() const { return triangles.empty(); }
+
+	// Forget the triangles, keeping the capacity of the vectors
+	void clear();
+
+	// Take over the triangles of a freshly computed hull along with the
+	// half-edge on the other side of each of their half-edges. Returns false
+	// (and clears the triangulation) if they don't form a closed mesh.
+	bool build(const std::vector<glm::uvec3>& hull_triangles, const std::vector<uint32_t>& hull_opposite, const std::vector<glm::vec3>& points);
+
+	// Delaunay triangulation of points on the unit sphere from scratch, which
+	// is their convex hull. Starts from the octahedron of the points furthest
+	// along each axis and inserts the rest one at a time in spatially coherent
+	// order, walking to the triangle under each point and flipping edges
+	// around it. Points almost on top of an inserted one are left out, like
+	// QuickHull does. Returns false (and clears the triangulation) if the
+	// points don't surround the origin or rounding produced a bad triangle.
+	bool triangulate(const std::vector<glm::vec3>& points);
+
+	// Flip edges until the triangulation is the convex hull of the moved
+	// points again. Gives up and returns false if more than max_flips flips
+	// are needed, or if the points moved so far that a triangle turned over.
+	bool repair(const std::vector<glm::vec3>& points, size_t max_flips);
+
+	size_t lastFlipCount() const { return flips_; }
+
+	// Voronoi cells in CSR form, found by walking the fan of triangles around
+	// each point counter-clockwise seen from outside the sphere. The cell of
+	// point i is cell_triangles[cell_offsets[i]] to cell_triangles[cell_offsets[i + 1] - 1],
+	// and cell_neighbors[j] is the point across the edge between
+	// cell_triangles[j] and the next triangle of the cell. Points that aren't
+	// on the hull get an empty cell. Returns false if the triangles around
+	// some point don't form a single fan.
+	bool walkCells(size_t num_points, std::vector<uint32_t>& cell_offsets, std::vector<uint32_t>& cell_triangles, std::vector<uint32_t>& cell_neighbors) const;
+
+private:
+	// +1 if the triangles wind counter-clockwise seen from outside the sphere, -1 otherwise
+	int winding_ = 1;
+	size_t flips_ = 0;
+	// Unit length directions of the points being triangulated
+	std::vector<glm::dvec3> directions_;
+
+	double orientation(const std::vector<glm::vec3>& points, uint32_t a, uint32_t b, uint32_t c) const;
+	bool isLocallyConvex(const std::vector<glm::vec3>& points, uint32_t he) const;
+	bool isLocallyDelaunay(uint32_t he) const;
+	bool flip(const std::vector<glm::vec3>& points, uint32_t he);
+	bool insert(const std::vector<glm::vec3>& points, uint32_t point, uint32_t& triangle, std::vector<uint32_t>& stack);
+	void link(uint32_t he1, uint32_t he2);
+};
+
+#endif
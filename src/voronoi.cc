@@ -1,11 +1,20 @@
 #include "voronoi.h"
+#include "circumcenter.h"
+#include "triangulation.h"
+#include "hull_workspace.h"
+#include "config.h"
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
 
 #include <glm/gtx/io.hpp>
 
-#include <QuickHull.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 template <typename T>
@@ -16,69 +25,65 @@ inline void printVector(std::vector<T> v) {
 	}
 }
 
-inline bool compareUvec(glm::uvec2 v1, glm::uvec2 v2)
-{
-	if (v1[0] < v2[0]) {
-		return true;
-	} else if (v1[0] > v2[0]) {
-		return false;
-	} else {
-		return v1[1] < v2[1];
-	}
-}
-
 // Constructor
-Voronoi::Voronoi(std::vector<glm::vec3> points)
+Voronoi::Voronoi(const std::vector<glm::vec3>& points, HullTriangulation* topology, HullWorkspace* workspace, HullAlgorithm algorithm)
 {
-	// Get the indices of points of triangles that make up the convex hull
-	// Need this in two forms
-	std::vector<size_t> point_indices(generateConvexHull(points));
-	getTriSimplices(point_indices);
+	// Without a hull to carry over, work on a throwaway one
+	HullTriangulation local_hull;
+	HullTriangulation& hull = topology ? *topology : local_hull;
+
+	// Get the triangles that make up the convex hull
+	size_t max_flips = static_cast<size_t>(points.size() * kMaxRelaxFlipsPerPoint);
+	if (topology && hull.repair(points, max_flips))
+	{
+		tri_simplices = hull.triangles;
+	}
+	else if (algorithm == HullAlgorithm::SphereDelaunay && hull.triangulate(points))
+	{
+		tri_simplices = hull.triangles;
+	}
+	else
+	{
+		// Without a workspace to borrow from, use throwaway buffers
+		std::unique_ptr<HullWorkspace> local_workspace(workspace ? nullptr : new HullWorkspace());
+		generateConvexHull(points, hull, workspace ? *workspace : *local_workspace);
+	}
 
 	// Get vertices from convex hull triangles (tetrahedrons w/ origin)
 	// Project circumcenter of each tetra onto surface of unit sphere
 	generateVertices(points);
 
-	std::vector<size_t> tri_indices;
-	for (size_t i = 0; i < tri_simplices.size(); i++)
-	{
-		tri_indices.push_back(i);
-		tri_indices.push_back(i);
-		tri_indices.push_back(i);
-	}
-
-	// Generate array associations
-	std::vector<glm::uvec2> array_associations;
-	for (size_t i = 0; i < tri_indices.size(); i++)
+	// Walk around each point to get its cell already in order. If the hull
+	// isn't a closed mesh, group the vertices by point and sort them instead.
+	if (hull.empty() || !hull.walkCells(points.size(), cell_offsets, cell_vertex_indices, cell_neighbors))
 	{
-		array_associations.push_back(glm::uvec2(point_indices[i], tri_indices[i]));
+		generateGroups(points.size());
+		sortGroups();
+		findNeighbors();
 	}
-	// Sort first by point index then tri index
-	std::sort(array_associations.begin(), array_associations.end(), compareUvec);
-
-	// Generate groups of vertices
-	generateGroups(array_associations);
-	sortGroups();
+	generateEdges();
 }
 
-std::vector<glm::vec3> Voronoi::getCenters()
+std::vector<glm::vec3> Voronoi::getCenters(const std::vector<glm::vec3>& points) const
 {
-	std::vector<glm::vec3> centers;
-	for (auto& group : groups)
+	// Each cell is independent, so the centers are computed in parallel
+	int num_cells = static_cast<int>(points.size());
+	std::vector<glm::vec3> centers(num_cells);
+	#pragma omp parallel for
+	for (int i = 0; i < num_cells; i++)
 	{
-		std::vector<glm::vec3> polygonVertices;
-		for (size_t idx : group)
-		{
-			polygonVertices.push_back(vertices[idx]);
-		}
-		centers.push_back(getCenter(polygonVertices));
+		if (cell_offsets[i] == cell_offsets[i + 1])
+			centers[i] = points[i];
+		else
+			centers[i] = getCenter(i);
 	}
 	return centers;
 }
 
 // Updating vectors for the mesh
-void Voronoi::getHullIndices(std::vector<glm::uvec2>& indices)
+void Voronoi::getHullIndices(std::vector<glm::uvec2>& indices) const
 {
+	indices.reserve(indices.size() + tri_simplices.size() * 3);
 	for (glm::uvec3 triSimplex : tri_simplices)
 	{
 		indices.push_back(glm::uvec2(triSimplex[0], triSimplex[1]));
@@ -87,133 +92,247 @@ void Voronoi::getHullIndices(std::vector<glm::uvec2>& indices)
 	}
 }
 
-void Voronoi::getHullFaces(std::vector<glm::uvec3>& faces)
+void Voronoi::moveHullFaces(std::vector<glm::uvec3>& faces)
 {
-	faces = this->tri_simplices;
+	faces = std::move(this->tri_simplices);
 }
 
-void Voronoi::getVerticesGroups(std::vector<glm::vec3>& vertices, std::vector<std::vector<size_t>>& groups)
+void Voronoi::moveCellNeighbors(std::vector<uint32_t>& cell_neighbors)
 {
-	vertices = this->vertices;
-	groups = this->groups;
+	cell_neighbors = std::move(this->cell_neighbors);
 }
 
-std::vector<size_t> Voronoi::generateConvexHull(std::vector<glm::vec3> points)
+void Voronoi::moveEdges(std::vector<glm::uvec2>& edges)
 {
-	using namespace quickhull;
-	QuickHull<float> qh;
+	edges = std::move(this->edges);
+}
 
-	auto hull = qh.getConvexHull(&points[0].x, points.size(), false, true, 0.000001f);
-	return hull.getIndexBuffer();
+void Voronoi::moveVerticesCells(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& cell_offsets, std::vector<uint32_t>& cell_vertex_indices)
+{
+	vertices = std::move(this->vertices);
+	cell_offsets = std::move(this->cell_offsets);
+	cell_vertex_indices = std::move(this->cell_vertex_indices);
 }
 
-void Voronoi::getTriSimplices(std::vector<size_t> point_indices)
+void Voronoi::generateConvexHull(const std::vector<glm::vec3>& points, HullTriangulation& hull, HullWorkspace& workspace)
 {
-	for (size_t i = 0; i < point_indices.size(); i += 3)
+	quickhull::QuickHull<float, uint32_t>& qh = workspace.quickhull;
+	qh.setParallel(true);
+
+	quickhull::HalfEdgeMesh<float, uint32_t>& mesh = workspace.mesh;
+	qh.getConvexHullAsMesh(&points[0].x, points.size(), false, mesh, 0.000001f);
+
+	// Number the half-edges of triangle t as 3t + i, going from tri[i] to
+	// tri[(i + 1) % 3] like HullTriangulation does
+	size_t num_tris = mesh.m_faces.size();
+	tri_simplices.resize(num_tris);
+	std::vector<uint32_t>& slots = workspace.slots;
+	slots.assign(mesh.m_halfEdges.size(), 0xFFFFFFFF);
+	for (size_t t = 0; t < num_tris; t++)
 	{
-		tri_simplices.push_back(glm::uvec3(point_indices[i], point_indices[i+1], point_indices[i+2]));
+		size_t he0 = mesh.m_faces[t].m_halfEdgeIndex;
+		size_t he1 = mesh.m_halfEdges[he0].m_next;
+		size_t he2 = mesh.m_halfEdges[he1].m_next;
+		tri_simplices[t] = glm::uvec3(mesh.m_vertexIndices[mesh.m_halfEdges[he0].m_endVertex],
+		                              mesh.m_vertexIndices[mesh.m_halfEdges[he1].m_endVertex],
+		                              mesh.m_vertexIndices[mesh.m_halfEdges[he2].m_endVertex]);
+		slots[he1] = static_cast<uint32_t>(3 * t);
+		slots[he2] = static_cast<uint32_t>(3 * t + 1);
+		slots[he0] = static_cast<uint32_t>(3 * t + 2);
 	}
+
+	std::vector<uint32_t>& opposite = workspace.opposite;
+	opposite.assign(num_tris * 3, 0xFFFFFFFF);
+	for (size_t he = 0; he < mesh.m_halfEdges.size(); he++)
+	{
+		if (slots[he] < opposite.size())
+			opposite[slots[he]] = slots[mesh.m_halfEdges[he].m_opp];
+	}
+	hull.build(tri_simplices, opposite, points);
 }
 
-void Voronoi::generateVertices(std::vector<glm::vec3> points)
+void Voronoi::generateVertices(const std::vector<glm::vec3>& points)
 {
-	for (glm::uvec3 tri_simplex : tri_simplices)
-	{
-		// From https://en.wikipedia.org/wiki/Tetrahedron#Circumcenter
-		// Can be simplified because one of the points is at the origin
-		glm::vec3 x1(points[tri_simplex[0]]);
-		glm::vec3 x2(points[tri_simplex[1]]);
-		glm::vec3 x3(points[tri_simplex[2]]);
-
-		glm::mat3 A(x1, x2, x3);
-		A = glm::transpose(A);
-		
-		// If three points and origin are coplanar
-		if (glm::determinant(A) == 0.0f) {
-
-			// If x1 and x2 are colinear, use x3 instead
-			if (glm::dot(x1, x2) == -1.0f) {
-				x2 = x3;
-			}
-
-			// From https://gamedev.stackexchange.com/questions/60630/how-do-i-find-the-circumcenter-of-a-triangle-in-3d
-			glm::vec3 x1Xx2(glm::cross(x1, x2));
-			glm::vec3 x2Xx1(-x1Xx2);
-			glm::vec3 term1(glm::cross(x1Xx2, x1));
-			glm::vec3 term2(glm::cross(x2Xx1, x2));
-			float denom(2 * glm::dot(x1Xx2, x1Xx2));
-
-			glm::vec3 circumcenter((term1 + term2) / denom);
-			vertices.push_back(glm::normalize(circumcenter));
-
-		// Usual case
-		} else {
-
-			glm::vec3 B(glm::dot(x1, x1), glm::dot(x2, x2), glm::dot(x3, x3));
-			B = 0.5f * B;
-
-			glm::vec3 circumcenter(glm::inverse(A) * B);
-			vertices.push_back(glm::normalize(circumcenter));
-		}
+	// Circumcenters are computed in SIMD batches, blocks of them in parallel
+	const int block_size = 1024;
+	int num_tris = static_cast<int>(tri_simplices.size());
+	int num_blocks = (num_tris + block_size - 1) / block_size;
+	vertices.resize(num_tris);
+	#pragma omp parallel for
+	for (int i = 0; i < num_blocks; i++)
+	{
+		int begin = i * block_size;
+		int count = std::min(block_size, num_tris - begin);
+		circumcenters(points.data(), &tri_simplices[begin], count, &vertices[begin]);
 	}
 }
 
-void Voronoi::generateGroups(std::vector<glm::uvec2> array_associations)
+void Voronoi::generateGroups(size_t num_points)
 {
-	size_t cur_group_idx = 0;
-	std::vector<size_t> cur_group;
-	for (glm::vec2 assoc : array_associations)
+	// Bucket the triangles by their points with a counting sort. Each thread
+	// counts a contiguous range of triangles into its own histogram, so the
+	// triangles of a cell end up in increasing order, the same as with a
+	// single thread. Points that aren't on the hull get an empty cell.
+	int num_tris = static_cast<int>(tri_simplices.size());
+	int num_threads = 1;
+#ifdef _OPENMP
+	num_threads = std::max(1, std::min(omp_get_max_threads(), num_tris / kMinTrisPerThread));
+#endif
+	std::vector<uint32_t> counts(num_threads * num_points, 0);
+
+	#pragma omp parallel for num_threads(num_threads)
+	for (int t = 0; t < num_threads; t++)
+	{
+		uint32_t* thread_counts = &counts[t * num_points];
+		int tri_end = static_cast<int>(static_cast<int64_t>(num_tris) * (t + 1) / num_threads);
+		for (int i = static_cast<int>(static_cast<int64_t>(num_tris) * t / num_threads); i < tri_end; i++)
+		{
+			thread_counts[tri_simplices[i][0]]++;
+			thread_counts[tri_simplices[i][1]]++;
+			thread_counts[tri_simplices[i][2]]++;
+		}
+	}
+
+	// Cell sizes, then their offsets
+	int num_cells = static_cast<int>(num_points);
+	cell_offsets.assign(num_points + 1, 0);
+	#pragma omp parallel for
+	for (int i = 0; i < num_cells; i++)
+	{
+		uint32_t size = 0;
+		for (int t = 0; t < num_threads; t++)
+			size += counts[t * num_points + i];
+		cell_offsets[i + 1] = size;
+	}
+	for (size_t i = 0; i < num_points; i++)
+	{
+		cell_offsets[i + 1] += cell_offsets[i];
+	}
+
+	// Turn the histograms into the position where each thread writes its
+	// first triangle of every cell
+	#pragma omp parallel for
+	for (int i = 0; i < num_cells; i++)
 	{
-		if (assoc[0] != cur_group_idx)
+		uint32_t position = cell_offsets[i];
+		for (int t = 0; t < num_threads; t++)
 		{
-			groups.push_back(cur_group);
-			cur_group.clear();
-			cur_group_idx++;
+			uint32_t count = counts[t * num_points + i];
+			counts[t * num_points + i] = position;
+			position += count;
 		}
+	}
 
-		cur_group.push_back(assoc[1]);
+	cell_vertex_indices.resize(cell_offsets[num_points]);
+	#pragma omp parallel for num_threads(num_threads)
+	for (int t = 0; t < num_threads; t++)
+	{
+		uint32_t* positions = &counts[t * num_points];
+		int tri_end = static_cast<int>(static_cast<int64_t>(num_tris) * (t + 1) / num_threads);
+		for (int i = static_cast<int>(static_cast<int64_t>(num_tris) * t / num_threads); i < tri_end; i++)
+		{
+			cell_vertex_indices[positions[tri_simplices[i][0]]++] = i;
+			cell_vertex_indices[positions[tri_simplices[i][1]]++] = i;
+			cell_vertex_indices[positions[tri_simplices[i][2]]++] = i;
+		}
 	}
-	groups.push_back(cur_group);
 }
 
-void Voronoi::sortGroups()
+void Voronoi::findNeighbors()
 {
-	std::vector<std::vector<size_t>> newGroups;
-	for (auto& group : groups)
+	// Two consecutive vertices of a cell come from hull triangles that share
+	// an edge: the cell's point and the neighbor's
+	cell_neighbors.resize(cell_vertex_indices.size());
+	int num_cells = static_cast<int>(cell_offsets.size()) - 1;
+	#pragma omp parallel for
+	for (int i = 0; i < num_cells; i++)
 	{
-		// Get the vertices in the polygon and calculate center
-		std::vector<glm::vec3> polygonVertices;
-		for (size_t idx : group)
+		uint32_t begin = cell_offsets[i];
+		uint32_t end = cell_offsets[i + 1];
+		for (uint32_t j = begin; j < end; j++)
 		{
-			polygonVertices.push_back(vertices[idx]);
+			const glm::uvec3& tri = tri_simplices[cell_vertex_indices[j]];
+			const glm::uvec3& next = tri_simplices[cell_vertex_indices[j + 1 < end ? j + 1 : begin]];
+			cell_neighbors[j] = kNoNeighbor;
+			for (int k = 0; k < 3; k++)
+				if (tri[k] != static_cast<uint32_t>(i) && (tri[k] == next[0] || tri[k] == next[1] || tri[k] == next[2]))
+					cell_neighbors[j] = tri[k];
 		}
-		glm::vec3 center(getCenter(polygonVertices));
+	}
+}
 
-		// Put in a struct so they can be sorted by rotation around first point
-		std::vector<polyVec> polyVecs;
-		for (size_t idx : group)
+void Voronoi::generateEdges()
+{
+	// Every edge borders two cells, keep it in the cell of the lower point
+	edges.clear();
+	edges.reserve(cell_vertex_indices.size() / 2);
+	size_t num_cells = cell_offsets.size() - 1;
+	for (size_t i = 0; i < num_cells; i++)
+	{
+		uint32_t begin = cell_offsets[i];
+		uint32_t end = cell_offsets[i + 1];
+		for (uint32_t j = begin; j < end; j++)
 		{
-			polyVec v(vertices[idx], center, polygonVertices[0], idx);
-			polyVecs.push_back(v);
+			if (cell_neighbors[j] > i)
+				edges.push_back(glm::uvec2(cell_vertex_indices[j], cell_vertex_indices[j + 1 < end ? j + 1 : begin]));
 		}
-		std::sort(polyVecs.begin(), polyVecs.end(), polyVec::compare);
+	}
+}
 
-		// Once sorted, add to list of new groups
-		std::vector<size_t> sorted_indices;
-		for (auto &v : polyVecs)
-			sorted_indices.push_back(v.idx);
-		newGroups.push_back(sorted_indices);
+void Voronoi::sortGroups()
+{
+	// Cells are sorted independently of each other, so spread them across threads
+	int num_cells = static_cast<int>(cell_offsets.size()) - 1;
+	#pragma omp parallel for schedule(dynamic, 256)
+	for (int i = 0; i < num_cells; i++)
+	{
+		uint32_t* cell = cell_vertex_indices.data();
+		sortCell(vertices, cell + cell_offsets[i], cell + cell_offsets[i + 1]);
 	}
-	// Reassign groups to sorted one
-	groups = newGroups;
 }
 
-glm::vec3 Voronoi::getCenter(std::vector<glm::vec3> vertices)
+void Voronoi::sortCell(const std::vector<glm::vec3>& vertices, uint32_t* begin, uint32_t* end)
+{
+	if (end - begin < 3)
+		return;
+
+	glm::vec3 center(0.0f);
+	for (uint32_t* idx = begin; idx != end; idx++)
+		center += vertices[*idx];
+	center /= static_cast<float>(end - begin);
+
+	// Tangent plane of the cell, with u towards the first vertex and v a
+	// quarter turn counter-clockwise from it
+	glm::vec3 normal(glm::normalize(center));
+	glm::vec3 u(glm::normalize(vertices[*begin] - center));
+	glm::vec3 v(glm::cross(normal, u));
+
+	// Key every vertex once by a pseudo-angle, which increases with the angle
+	// from u like atan2 but is cheaper. The first vertex always stays first.
+	thread_local std::vector<std::pair<float, uint32_t>> keyed;
+	keyed.clear();
+	keyed.push_back(std::make_pair(-1.0f, *begin));
+	for (uint32_t* idx = begin + 1; idx != end; idx++)
+	{
+		glm::vec3 dir(vertices[*idx] - center);
+		float x = glm::dot(dir, u);
+		float y = glm::dot(dir, v);
+		float p = y / (std::abs(x) + std::abs(y));
+		float key = x >= 0.0f ? (y >= 0.0f ? p : 4.0f + p) : 2.0f - p;
+		keyed.push_back(std::make_pair(key, *idx));
+	}
+	std::sort(keyed.begin(), keyed.end());
+
+	for (size_t j = 0; j < keyed.size(); j++)
+		begin[j] = keyed[j].second;
+}
+
+glm::vec3 Voronoi::getCenter(size_t cell) const
 {
 	glm::vec3 sum(0.0f);
-	for (auto &v : vertices)
+	for (uint32_t i = cell_offsets[cell]; i < cell_offsets[cell + 1]; i++)
 	{
-		sum += v;
+		sum += vertices[cell_vertex_indices[i]];
 	}
-	return sum / static_cast<float>(vertices.size());
+	return sum / static_cast<float>(cell_offsets[cell + 1] - cell_offsets[cell]);
 }
\ No newline at end of file
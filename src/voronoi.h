@@ -1,91 +1,78 @@
 #ifndef VORONOI_H
 #define VORONOI_H
 
+#include <cstdint>
 #include <vector>
 #include <iostream>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/io.hpp>
 
-// Assumes center is inside the unit sphere (i.e. not on the surface of it)
-struct polyVec {
+class HullTriangulation;
+struct HullWorkspace;
 
-	polyVec(glm::vec3 pt, glm::vec3 cen, glm::vec3 tp, size_t index) : point(pt), center(cen), top(tp), idx(index) {}
-
-	glm::vec3 point;
-	glm::vec3 center;
-	glm::vec3 top;
-	size_t idx;
-
-	bool CCW;
-	float dot;
-
-	// Sort vertices in order either clockwise or counter-clockwise
-	static bool compare(polyVec v1, polyVec v2) {
-
-		// It's the first vertex, it should stay first
-		if (v1.point == v1.top) {
-			return true;
-		} else if (v2.point == v2.top) {
-			return false;
-		}
-
-		v1.setCCW_dot();
-		v2.setCCW_dot();
-		// If both rotating CCW, return v with smallest angle to up
-		if (v1.CCW && v2.CCW) {
-			return v1.dot > v2.dot;
-		// Return the one that rotates CCW
-		} else if (v1.CCW) {
-			return true;
-		} else if (v2.CCW) {
-			return false;
-
-		// If both CW, return v with largest angle to up
-		} else {
-			return v1.dot < v2.dot;
-		}
-	}
-
-	void setCCW_dot() {
-		glm::vec3 outCenter(glm::normalize(center));
-		glm::vec3 upNorm(glm::normalize(top - center));
-		glm::vec3 dirNorm(glm::normalize(point - center));
-
-		glm::vec3 normal(glm::normalize(glm::cross(upNorm, dirNorm)));
-
-		float normDot(glm::dot(normal, glm::normalize(center - outCenter)));
-
-		CCW = normDot < 0.0f;
-		dot = glm::dot(upNorm, dirNorm);
-	}
+// How a new convex hull of the points is computed
+enum class HullAlgorithm {
+	// General 3D convex hull
+	QuickHull,
+	// Incremental spherical Delaunay triangulation, which relies on the points
+	// being on the unit sphere. Falls back to QuickHull if it fails.
+	SphereDelaunay
 };
 
 class Voronoi {
 public:
-	Voronoi(std::vector<glm::vec3> points);
-
-	std::vector<glm::vec3> getCenters();
-	void getHullIndices(std::vector<glm::uvec2>& indices);
-	void getHullFaces(std::vector<glm::uvec3>& faces);
-
-	void getVerticesGroups(std::vector<glm::vec3>& vertices, std::vector<std::vector<size_t>>& groups);
+	// Cell neighbor of an edge whose two triangles share no point besides the
+	// cell's own, which only a degenerate hull has
+	static const uint32_t kNoNeighbor = 0xFFFFFFFF;
+
+	// If topology holds the hull of a previous, slightly different set of
+	// points, it is repaired and reused instead of computing a new hull.
+	// Either way it is left holding the hull of these points. A workspace
+	// lends its buffers to the hull computation.
+	Voronoi(const std::vector<glm::vec3>& points, HullTriangulation* topology = nullptr, HullWorkspace* workspace = nullptr,
+	        HullAlgorithm algorithm = HullAlgorithm::QuickHull);
+
+	// Center of each point's cell. Points that didn't make it onto the hull
+	// (near duplicates) have an empty cell and keep their position.
+	std::vector<glm::vec3> getCenters(const std::vector<glm::vec3>& points) const;
+	void getHullIndices(std::vector<glm::uvec2>& indices) const;
+
+	// Hand the hull faces, vertices and cells over to the caller without
+	// copying them. The Voronoi is left without them afterwards.
+	void moveHullFaces(std::vector<glm::uvec3>& faces);
+	void moveVerticesCells(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& cell_offsets, std::vector<uint32_t>& cell_vertex_indices);
+	void moveCellNeighbors(std::vector<uint32_t>& cell_neighbors);
+	void moveEdges(std::vector<glm::uvec2>& edges);
+
+	// Order the vertices of a cell counter-clockwise seen from outside the
+	// sphere, starting at the cell's first vertex
+	static void sortCell(const std::vector<glm::vec3>& vertices, uint32_t* begin, uint32_t* end);
 
 private:
 	// Voronoi vertices
 	std::vector<glm::vec3> vertices;
-	// Groups of vertices that represent a Voronoi cell
-	std::vector<std::vector<size_t>> groups;
+	// Cell of point i, i.e. the polygon of Voronoi vertices around it, is
+	// cell_vertex_indices[cell_offsets[i]] to cell_vertex_indices[cell_offsets[i + 1] - 1]
+	std::vector<uint32_t> cell_offsets;
+	std::vector<uint32_t> cell_vertex_indices;
+	// Point on the other side of the edge from cell_vertex_indices[j] to the
+	// next vertex of its cell, or kNoNeighbor
+	std::vector<uint32_t> cell_neighbors;
+	// Voronoi edges, each once
+	std::vector<glm::uvec2> edges;
 
 	std::vector<glm::uvec3> tri_simplices;
 
-	std::vector<size_t> generateConvexHull(std::vector<glm::vec3> points);
-	void getTriSimplices(std::vector<size_t> point_indices);
-	void generateVertices(std::vector<glm::vec3> points);
-	void generateGroups(std::vector<glm::uvec2> array_associations);
+	void generateConvexHull(const std::vector<glm::vec3>& points, HullTriangulation& hull, HullWorkspace& workspace);
+	void generateVertices(const std::vector<glm::vec3>& points);
+	void generateGroups(size_t num_points);
 	void sortGroups();
+	void findNeighbors();
+	void generateEdges();
 
-	static glm::vec3 getCenter(std::vector<glm::vec3> vertices);
+	// Average of the vertices of a cell
+	glm::vec3 getCenter(size_t cell) const;
 };
 
 #endif
\ No newline at end of file